@@ -6,6 +6,9 @@ clang++ \
     -I/usr/include/c++/13 \
     -I/usr/lib/gcc/x86_64-linux-gnu \
     $(pkg-config --cflags x11) \
-    ./src/main.cpp ./src/chip8.cpp ./src/platform_x11.cpp ./src/input.cpp \
+    ./src/main.cpp ./src/chip8.cpp ./src/rom.cpp ./src/sha1.cpp ./src/romdb.cpp \
+    ./src/file_watch.cpp ./src/profiler.cpp ./src/trace.cpp ./src/metrics.cpp ./src/present.cpp \
+    ./src/debugger.cpp ./src/gdb_stub.cpp ./src/analysis.cpp ./src/recompiled.cpp ./src/fusion.cpp \
+    ./src/platform_x11.cpp ./src/input.cpp \
     -o chip8_x11.exe \
     $(pkg-config --libs x11)
@@ -10,6 +10,8 @@ cl ^
     /std:c++20 ^
     /EHsc ^
     ..\src\chip8.cpp ^
+    ..\src\rom.cpp ^
+    ..\src\sha1.cpp ^
     ..\src\input.cpp ^
     ..\src\platform_win32.cpp ^
     /link user32.lib gdi32.lib shell32.lib
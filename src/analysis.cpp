@@ -0,0 +1,185 @@
+#include "analysis.h"
+
+#include <algorithm>
+
+namespace
+{
+// Last address an instruction can start at
+constexpr uint16_t lastInstruction = 0xffe;
+
+uint16_t opcodeAt(const Chip8& chip8, uint16_t address)
+{
+    return U8_CONCAT(chip8.memory[address & 0xfff], chip8.memory[(address + 1) & 0xfff]);
+}
+
+bool isSkip(OpcodeClass opcodeClass)
+{
+    switch (opcodeClass)
+    {
+    case OpcodeClass::SkipEqImm:
+    case OpcodeClass::SkipNeImm:
+    case OpcodeClass::SkipEqReg:
+    case OpcodeClass::SkipNeReg:
+    case OpcodeClass::SkipKey:
+    case OpcodeClass::SkipNoKey:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool endsBlock(OpcodeClass opcodeClass)
+{
+    switch (opcodeClass)
+    {
+    case OpcodeClass::Jump:
+    case OpcodeClass::Call:
+    case OpcodeClass::Ret:
+    case OpcodeClass::JumpOffset:
+    case OpcodeClass::Unknown:
+        return true;
+    default:
+        return isSkip(opcodeClass);
+    }
+}
+
+// Statically known successors of one instruction, in the order the interpreter tries them
+std::vector<uint16_t> successorsOf(const Chip8& chip8, QuirkProfile profile, uint16_t address, uint16_t opcode)
+{
+    const auto next = static_cast<uint16_t>(address + InstructionLength(opcode, profile));
+    const auto opcodeClass = ClassifyOpcode(opcode, profile);
+    switch (opcodeClass)
+    {
+    case OpcodeClass::Jump:
+        return {static_cast<uint16_t>(opcode & 0xfff)};
+    case OpcodeClass::Call:
+        return {static_cast<uint16_t>(opcode & 0xfff), next};
+    case OpcodeClass::Ret:
+    case OpcodeClass::JumpOffset:
+    case OpcodeClass::Unknown:
+        return {};
+    default:
+        if (isSkip(opcodeClass))
+        {
+            return {next, static_cast<uint16_t>(next + InstructionLength(opcodeAt(chip8, next), profile))};
+        }
+        return {next};
+    }
+}
+}  // namespace
+
+const BasicBlock* ProgramAnalysis::BlockAt(uint16_t address) const
+{
+    auto block = blocks.upper_bound(address);
+    if (block == blocks.begin())
+    {
+        return nullptr;
+    }
+    block--;
+    return address < block->second.end && code[address] ? &block->second : nullptr;
+}
+
+bool ProgramAnalysis::IsCode(uint16_t address) const
+{
+    address &= 0xfff;
+    return code[address] || (address > 0 && code[address - 1]);
+}
+
+ProgramAnalysis AnalyzeProgram(const Chip8& chip8, QuirkProfile profile, uint16_t entry)
+{
+    ProgramAnalysis analysis;
+    std::bitset<4096> leaders;
+    leaders.set(entry & 0xfff);
+
+    // Mark every reachable instruction
+    std::vector<uint16_t> pending{static_cast<uint16_t>(entry & 0xfff)};
+    while (!pending.empty())
+    {
+        const auto address = pending.back();
+        pending.pop_back();
+        if (analysis.code[address])
+        {
+            continue;
+        }
+        analysis.code.set(address);
+        if ((address > 0 && analysis.code[address - 1]) || (address < lastInstruction && analysis.code[address + 1]))
+        {
+            analysis.issues.push_back({address, opcodeAt(chip8, address), "overlaps another instruction"});
+        }
+
+        const auto opcode = opcodeAt(chip8, address);
+        const auto opcodeClass = ClassifyOpcode(opcode, profile);
+        if (opcodeClass == OpcodeClass::Unknown)
+        {
+            analysis.issues.push_back({address, opcode, "unknown opcode"});
+        }
+        else if (opcodeClass == OpcodeClass::JumpOffset)
+        {
+            analysis.issues.push_back({address, opcode, "jump target only known at run time"});
+        }
+        else if (opcodeClass == OpcodeClass::Call)
+        {
+            analysis.callTargets.set(opcode & 0xfff);
+        }
+        else if (opcodeClass == OpcodeClass::LoadI)
+        {
+            analysis.dataReferences.set(opcode & 0xfff);
+        }
+
+        for (const auto successor : successorsOf(chip8, profile, address, opcode))
+        {
+            if (successor < romStartAddress || successor > lastInstruction)
+            {
+                analysis.issues.push_back({address, opcode, "control leaves the program"});
+                continue;
+            }
+            if (endsBlock(opcodeClass))
+            {
+                leaders.set(successor);
+            }
+            pending.push_back(successor);
+        }
+    }
+
+    // Cut the instructions into blocks at every leader and after every branch
+    for (uint16_t start = 0; start < leaders.size(); start++)
+    {
+        if (!leaders[start] || !analysis.code[start])
+        {
+            continue;
+        }
+        BasicBlock block{start, start};
+        for (auto address = start;; address += InstructionLength(opcodeAt(chip8, address), profile))
+        {
+            const auto opcode = opcodeAt(chip8, address);
+            block.end = static_cast<uint16_t>(address + InstructionLength(opcode, profile));
+            block.exit = ClassifyOpcode(opcode, profile);
+            const auto next = block.end;
+            if (endsBlock(block.exit) || next > lastInstruction || leaders[next])
+            {
+                for (const auto successor : successorsOf(chip8, profile, address, opcode))
+                {
+                    if (successor >= romStartAddress && successor <= lastInstruction)
+                    {
+                        block.successors.push_back(successor);
+                    }
+                }
+                break;
+            }
+        }
+        analysis.blocks.emplace(start, std::move(block));
+    }
+
+    analysis.patchableCode = analysis.dataReferences & analysis.code;
+    analysis.dataReferences &= ~analysis.code;
+    for (auto& issue : analysis.issues)
+    {
+        if (analysis.patchableCode[issue.address] && ClassifyOpcode(issue.opcode, profile) == OpcodeClass::Unknown)
+        {
+            issue.message = "unknown opcode, likely written by the program first";
+        }
+    }
+    std::sort(analysis.issues.begin(), analysis.issues.end(),
+              [](const AnalysisIssue& a, const AnalysisIssue& b) { return a.address < b.address; });
+    return analysis;
+}
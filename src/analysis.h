@@ -0,0 +1,56 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "chip8.h"
+#include "opcode.h"
+
+// Straight-line run of instructions entered only at start
+struct BasicBlock
+{
+    uint16_t start = 0;
+    // One past the last byte of the last instruction
+    uint16_t end = 0;
+    // Where control goes next: jump and call targets, the instruction after a call or skip, the skipped-to address.
+    // Empty after 00EE, BNNN, an unknown opcode or the end of memory.
+    std::vector<uint16_t> successors;
+    // Class of the last instruction
+    OpcodeClass exit = OpcodeClass::Unknown;
+};
+
+struct AnalysisIssue
+{
+    uint16_t address = 0;
+    uint16_t opcode = 0;
+    const char* message = "";
+};
+
+// Code and data of a program found by following every 1NNN, 2NNN and skip from its entry point. Anything the
+// interpreter can only learn at run time (BNNN targets, code written by the program) is left out and reported. Only
+// the base 4 KiB is covered. Opcodes are read as the quirk profile knows them, with xochip F000 NNNN is one
+// instruction of four bytes.
+struct ProgramAnalysis
+{
+    // First bytes of the reachable instructions
+    std::bitset<4096> code;
+    std::bitset<4096> callTargets;
+    // ANNN operands that are not code, usually sprites
+    std::bitset<4096> dataReferences;
+    // Instructions an ANNN points at, FX33/FX55 may rewrite them at run time
+    std::bitset<4096> patchableCode;
+    // By start address
+    std::map<uint16_t, BasicBlock> blocks;
+    std::vector<AnalysisIssue> issues;
+
+    // Block containing the instruction at address, nullptr when it is not reachable code
+    [[nodiscard]] const BasicBlock* BlockAt(uint16_t address) const;
+    // Instruction bytes, counting both bytes of every instruction
+    [[nodiscard]] bool IsCode(uint16_t address) const;
+};
+
+// Analyses the program loaded in memory as profile runs it, starting from entry
+[[nodiscard]] ProgramAnalysis AnalyzeProgram(const Chip8& chip8, QuirkProfile profile,
+                                             uint16_t entry = romStartAddress);
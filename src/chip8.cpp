@@ -1,51 +1,212 @@
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <format>
-#include <fstream>
 #include <iostream>
 #include <string>
-#include <random>
 
 #include "bit.h"
 #include "chip8.h"
-#include "input.h"
+#include "opcode.h"
+#include "rom.h"
 
-Chip8::Chip8()
+namespace
 {
-    std::srand(time(NULL));
+uint8_t nextRandom(uint32_t& state)
+{
+    // xorshift32
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state & 0xff;
+}
+
+uint64_t hashMix(uint64_t h, uint64_t value)
+{
+    h ^= value * 0x9e3779b97f4a7c15ull;
+    h = (h << 27) | (h >> 37);
+    return h * 0xff51afd7ed558ccdull;
+}
+
+// SUPER-CHIP 00CN, 00FB, 00FC, 00FE and 00FF, false for any other opcode
+bool displayControl(Chip8& chip8, uint16_t opcode)
+{
+    if ((opcode & 0xfff0) == 0x00c0)
+    {
+        chip8.ScrollDown(opcode & 0xf);
+        return true;
+    }
+
+    switch (opcode)
+    {
+    case 0x00fb:
+        chip8.ScrollRight();
+        return true;
+    case 0x00fc:
+        chip8.ScrollLeft();
+        return true;
+    case 0x00fe:
+        chip8.SetHires(false);
+        return true;
+    case 0x00ff:
+        chip8.SetHires(true);
+        return true;
+    default:
+        return false;
+    }
+}
+}  // namespace
+
+Chip8::Chip8() : Chip8(static_cast<uint32_t>(time(NULL))) {}
+
+Chip8::Chip8(uint32_t seed)
+{
+    // xorshift gets stuck on zero
+    rng = seed ? seed : 0x2545f491;
 
     // Load fontset
     std::memcpy(&memory[0x50], fontset, sizeof(fontset));
 }
 
-bool Chip8::LoadRom(const std::string& path)
+const char* RomErrorMessage(RomError error)
 {
-    std::fstream fileStream{path, std::ios::binary | std::ios::in};
-    if (!fileStream.is_open())
+    switch (error)
     {
-        std::cout << std::format("Failed to open rom: {}\n", path.c_str());
-        return false;
+    case RomError::None:
+        return "ok";
+    case RomError::OpenFailed:
+        return "cannot open file";
+    case RomError::ReadFailed:
+        return "read failed";
+    case RomError::TooLarge:
+        return "too large for the quirk profile's memory";
+    }
+    return "unknown error";
+}
+
+RomError Chip8::LoadRom(const std::string& path, QuirkProfile profile)
+{
+    RomImage image;
+    const auto error = ReadRomFile(path, image, profile);
+    return error == RomError::None ? LoadRom(image.Bytes(), profile) : error;
+}
+
+RomError Chip8::LoadRom(std::span<const uint8_t> image, QuirkProfile profile)
+{
+    const auto limit = highMemory != nullptr ? MaxRomSize(profile) : maxRomSize;
+    if (image.size() > static_cast<size_t>(limit))
+    {
+        return RomError::TooLarge;
     }
 
-    pc = 512;
-    int offset = 512;
+    // Whatever does not fit below chip8MemorySize continues at the start of high memory
+    const auto low = std::min<size_t>(image.size(), maxRomSize);
+    if (low > 0)
+    {
+        std::memcpy(&memory[romStartAddress], image.data(), low);
+    }
+    std::memset(&memory[romStartAddress + low], 0, maxRomSize - low);
+    if (highMemory != nullptr)
+    {
+        const auto high = image.size() - low;
+        if (high > 0)
+        {
+            std::memcpy(highMemory, image.data() + low, high);
+        }
+        std::memset(highMemory + high, 0, highMemorySize - high);
+    }
+    pc = romStartAddress;
+    return RomError::None;
+}
+
+XoChip8::XoChip8(const XoChip8& other) : chip8(other.chip8)
+{
+    std::memcpy(highMemory, other.highMemory, sizeof(highMemory));
+    chip8.highMemory = highMemory;
+}
+
+XoChip8& XoChip8::operator=(const XoChip8& other)
+{
+    chip8 = other.chip8;
+    std::memcpy(highMemory, other.highMemory, sizeof(highMemory));
+    chip8.highMemory = highMemory;
+    return *this;
+}
+
+const char* QuirkProfileName(QuirkProfile profile)
+{
+    switch (profile)
+    {
+    case QuirkProfile::Cosmac:
+        return "cosmac";
+    case QuirkProfile::SuperChip:
+        return "schip";
+    case QuirkProfile::XoChip:
+        return "xochip";
+    default:
+        return "default";
+    }
+}
 
-    while(fileStream.read(reinterpret_cast<char*>(&memory[offset++]), 1)) {}
-    return true;
+bool ParseQuirkProfile(const std::string& name, QuirkProfile& profile)
+{
+    for (int i = 0; i < quirkProfileCount; i++)
+    {
+        if (name == QuirkProfileName(static_cast<QuirkProfile>(i)))
+        {
+            profile = static_cast<QuirkProfile>(i);
+            return true;
+        }
+    }
+    return false;
 }
 
+template <QuirkProfile profile>
 void Chip8::ExecuteNext()
 {
-    const auto hi = memory[pc];
-    const auto lo = memory[pc + 1];
+    constexpr auto quirks = QuirksOf(profile);
+    // Addresses wrap at 4 KiB outside XO-CHIP, pc and I can be pushed past it by BNNN and FX1E
+    const auto byte = [this](unsigned address) -> uint8_t& { return MemoryAt<profile>(address); };
+
+    const auto hi = byte(pc);
+    const auto lo = byte(pc + 1);
     const auto opcode = U8_CONCAT(hi, lo);
     const auto prefix = (hi & 0xf0) >> 4;
-   
-    /* std::cout << std::format("OPCODE: 0x{:04x}\n", opcode); */
+
+    // A taken skip steps over the next instruction, XO-CHIP's F000 NNNN being twice as long
+    const auto skipped = [&]
+    {
+        if constexpr (quirks.xoChip)
+        {
+            return U8_CONCAT(byte(pc + 2), byte(pc + 3)) == 0xf000 ? 6 : 4;
+        }
+        return 4;
+    };
 
     switch (prefix)
     {
     case 0:
     {
+        if constexpr (quirks.schipDisplay)
+        {
+            if (displayControl(*this, opcode))
+            {
+                pc += 2;
+                break;
+            }
+        }
+        if constexpr (quirks.xoChip)
+        {
+            if ((opcode & 0xfff0) == 0x00d0)
+            {
+                ScrollUp(opcode & 0xf);
+                pc += 2;
+                break;
+            }
+        }
+
         const auto suffix = opcode & 0xf;
 
         switch (suffix)
@@ -53,7 +214,7 @@ void Chip8::ExecuteNext()
         // 0NNN
         case 0:
         {
-            std::memset(videoBuffer, 0, sizeof(videoBuffer));
+            Clear();
             pc += 2;
             break;
         }
@@ -61,8 +222,8 @@ void Chip8::ExecuteNext()
         // 00EE
         case 0xe:
         {
-            pc = stack.top();
-            stack.pop();
+            sp--;
+            pc = stack[sp % stackSize];
             break;
         }
         }
@@ -78,7 +239,8 @@ void Chip8::ExecuteNext()
     // CALL NNN
     case 2:
     {
-        stack.push(pc + 2);
+        stack[sp % stackSize] = pc + 2;
+        sp++;
         pc = (opcode & 0x0fff);
         break;
     }
@@ -89,7 +251,7 @@ void Chip8::ExecuteNext()
         const auto value = (opcode & 0x00ff);
         if (regs[x] == value)
         {
-            pc += 4;
+            pc += skipped();
             break;
         }
         pc += 2;
@@ -101,7 +263,7 @@ void Chip8::ExecuteNext()
         const auto x = (opcode & 0x0f00) >> 8;
         if (regs[x] != lo)
         {
-            pc += 4;
+            pc += skipped();
             break;
         }
         pc += 2;
@@ -112,9 +274,32 @@ void Chip8::ExecuteNext()
     {
         const auto x = (opcode & 0x0f00) >> 8;
         const auto y = (opcode & 0x00f0) >> 4;
+        if constexpr (quirks.xoChip)
+        {
+            // 5XY2/5XY3 store/load VX to VY at I, in either direction, and leave I alone
+            if ((opcode & 0xf) == 2 || (opcode & 0xf) == 3)
+            {
+                const auto step = x <= y ? 1 : -1;
+                for (int i = 0; i <= std::abs(y - x); i++)
+                {
+                    auto& cell = byte(ri + i);
+                    auto& reg = regs[x + i * step];
+                    if ((opcode & 0xf) == 2)
+                    {
+                        cell = reg;
+                    }
+                    else
+                    {
+                        reg = cell;
+                    }
+                }
+                pc += 2;
+                break;
+            }
+        }
         if (regs[x] == regs[y])
         {
-            pc += 4;
+            pc += skipped();
             break;
         }
         pc += 2;
@@ -154,18 +339,30 @@ void Chip8::ExecuteNext()
         case 1:
         {
             regs[x] |= regs[y];
+            if constexpr (quirks.logicClearsVf)
+            {
+                regs[15] = 0;
+            }
             break;
         }
         // 8XY2
         case 2:
         {
             regs[x] &= regs[y];
+            if constexpr (quirks.logicClearsVf)
+            {
+                regs[15] = 0;
+            }
             break;
         }
         // 8XY3
         case 3:
         {
             regs[x] ^= regs[y];
+            if constexpr (quirks.logicClearsVf)
+            {
+                regs[15] = 0;
+            }
             break;
         }
         // 8XY4
@@ -186,8 +383,17 @@ void Chip8::ExecuteNext()
         // 8XY6
         case 6:
         {
-            regs[x] = (regs[y] >> 1);
-            regs[15] = READ_BIT(regs[y], 0);
+            if constexpr (quirks.shiftReadsVy)
+            {
+                regs[x] = (regs[y] >> 1);
+                regs[15] = READ_BIT(regs[y], 0);
+            }
+            else
+            {
+                const auto value = regs[x];
+                regs[x] = (value >> 1);
+                regs[15] = READ_BIT(value, 0);
+            }
             break;
         }
         // 8XY7
@@ -200,8 +406,17 @@ void Chip8::ExecuteNext()
         // 8XYE
         case 0xe:
         {
-            regs[x] = (regs[y] << 1);
-            regs[15] = READ_BIT(regs[y], 7);
+            if constexpr (quirks.shiftReadsVy)
+            {
+                regs[x] = (regs[y] << 1);
+                regs[15] = READ_BIT(regs[y], 7);
+            }
+            else
+            {
+                const auto value = regs[x];
+                regs[x] = (value << 1);
+                regs[15] = READ_BIT(value, 7);
+            }
             break;
         }
         }
@@ -216,7 +431,7 @@ void Chip8::ExecuteNext()
         const auto y = (opcode & 0x00f0) >> 4;
         if (regs[x] != regs[y])
         {
-            pc += 4;
+            pc += skipped();
             break;
         }
         pc += 2;
@@ -229,17 +444,17 @@ void Chip8::ExecuteNext()
         pc += 2;
         break;
     }
-    // BNNN
+    // BNNN, BXNN
     case 0xb:
     {
-        pc = (opcode & 0x0fff) + regs[0];
+        pc = (opcode & 0x0fff) + regs[quirks.jumpAddsVx ? (opcode & 0x0f00) >> 8 : 0];
         break;
     }
     // CXNN
     case 0xc:
     {
         const auto x = (opcode & 0x0f00) >> 8;
-        regs[x] = (rand() % 0xFF) & (opcode & 0x00FF);
+        regs[x] = nextRandom(rng) & lo;
         pc += 2;
         break;
     }
@@ -248,31 +463,7 @@ void Chip8::ExecuteNext()
     {
         const auto x = (opcode & 0x0f00) >> 8;
         const auto y = (opcode & 0x00f0) >> 4;
-        const auto spriteHeight = opcode & 0x000f;
-        regs[0xf] = 0;
-
-        for (int i = 0; i < spriteHeight; ++i)
-        {
-            const auto spriteByte = memory[ri + i];
-
-            for (int j = 0; j < 8; ++j)
-            {
-                const auto sprite = spriteByte & (0x80 >> j);
-                auto* pixel = &videoBuffer[(regs[y] + i) * chip8Width + (regs[x] + j)];
-
-                if (sprite)
-                {
-                    // Screen pixel also on - collision
-                    if (*pixel)
-                    {
-                        regs[15] = 1;
-                    }
-
-                    *pixel ^= 0x0000ff00;
-                }
-            }
-        }
-
+        DrawSprite<profile>(regs[x], regs[y], opcode & 0x000f);
         pc += 2;
         break;
     }
@@ -285,9 +476,9 @@ void Chip8::ExecuteNext()
         // EX9E
         case 0x9e:
         {
-            if (IsKeyPressed(regs[idx]))
+            if (KeyDown(regs[idx]))
             {
-                pc += 4;
+                pc += skipped();
             }
             else 
             {
@@ -298,9 +489,9 @@ void Chip8::ExecuteNext()
         // EXA1
         case 0xa1:
         {
-            if (!IsKeyPressed(regs[idx]))
+            if (!KeyDown(regs[idx]))
             {
-                pc += 4;
+                pc += skipped();
             }
             else 
             {
@@ -318,6 +509,45 @@ void Chip8::ExecuteNext()
 
         switch (lo)
         {
+        // F000 NNNN
+        case 0x00:
+        {
+            if constexpr (quirks.xoChip)
+            {
+                if (idx == 0)
+                {
+                    ri = U8_CONCAT(byte(pc + 2), byte(pc + 3));
+                    pc += 4;
+                }
+            }
+            break;
+        }
+        // FN01
+        case 0x01:
+        {
+            if constexpr (quirks.xoChip)
+            {
+                planeMask = idx & ((1 << planeCount) - 1);
+                pc += 2;
+            }
+            break;
+        }
+        // F002
+        case 0x02:
+        {
+            if constexpr (quirks.xoChip)
+            {
+                if (idx == 0)
+                {
+                    for (int i = 0; i < audioPatternSize; i++)
+                    {
+                        audioPattern[i] = byte(ri + i);
+                    }
+                    pc += 2;
+                }
+            }
+            break;
+        }
         // FX07
         case 0x07:
         {
@@ -328,16 +558,16 @@ void Chip8::ExecuteNext()
         // FX0A
         case 0x0a:
         {
+            // Block until key pressed, pc stays on this instruction
             for (int i = 0; i < inputKeyCount; i++)
             {
-                if (IsKeyPressed(i))
+                if (KeyDown(i))
                 {
                     regs[idx] = i;
+                    pc += 2;
                     break;
                 }
             }
-            // Block until key pressed
-            pc -= 2;
             break;
         }
         // FX15
@@ -373,18 +603,32 @@ void Chip8::ExecuteNext()
         case 0x33:
         {
             const auto x = regs[idx];
-            memory[ri] = x / 100;
-            memory[ri + 1] = (x % 100) / 10;
-            memory[ri + 2] = ((x % 100) % 10) / 1;
+            byte(ri) = x / 100;
+            byte(ri + 1) = (x % 100) / 10;
+            byte(ri + 2) = ((x % 100) % 10) / 1;
             pc += 2;
             break;
         }
+        // FX3A
+        case 0x3a:
+        {
+            if constexpr (quirks.xoChip)
+            {
+                pitch = regs[idx];
+                pc += 2;
+            }
+            break;
+        }
         // FX55
         case 0x55:
         {
             for (int i = 0; i <= idx; ++i)
             {
-                memory[ri + i] = regs[i];
+                byte(ri + i) = regs[i];
+            }
+            if constexpr (quirks.loadStoreAdvancesI)
+            {
+                ri += idx + 1;
             }
             pc += 2;
             break;
@@ -394,7 +638,11 @@ void Chip8::ExecuteNext()
         {
             for (int i = 0; i <= idx; ++i)
             {
-                regs[i] = memory[ri + i];
+                regs[i] = byte(ri + i);
+            }
+            if constexpr (quirks.loadStoreAdvancesI)
+            {
+                ri += idx + 1;
             }
             pc += 2;
             break;
@@ -409,6 +657,7 @@ void Chip8::ExecuteNext()
         abort();
     }
 
+    timerTicks += (rdelay | rsound) != 0;
     if (rdelay > 0) 
     {
         rdelay--;
@@ -423,3 +672,334 @@ void Chip8::ExecuteNext()
         rsound--;
     }
 }
+
+template <QuirkProfile profile>
+void Chip8::DrawSprite(uint8_t x, uint8_t y, int n)
+{
+    constexpr auto quirks = QuirksOf(profile);
+    // Only XO-CHIP selects planes, the others always draw into plane 0
+    constexpr auto planes = quirks.xoChip ? planeCount : 1;
+
+    // DXY0 is 16 rows of two bytes
+    const bool wide = quirks.schipDisplay && n == 0;
+    const auto rows = wide ? 16 : n;
+    const bool large = quirks.schipDisplay && hires;
+    const auto width = large ? hiresWidth : chip8Width;
+    const auto height = large ? hiresHeight : chip8Height;
+
+    // Start position wraps, the sprite itself is clipped at the edges unless the profile wraps it. Both sizes are
+    // powers of two.
+    const auto px = x & (width - 1);
+    const auto py = y & (height - 1);
+    regs[0xf] = 0;
+
+    // Each selected plane takes the next sprite in memory
+    auto address = ri;
+    for (int plane = 0; plane < planes; plane++)
+    {
+        if (!(planeMask & (1 << plane)))
+        {
+            continue;
+        }
+        auto* bitboard = display[plane];
+
+        for (int i = 0; i < rows && (quirks.spritesWrap || py + i < height); ++i)
+        {
+            // Whole sprite row in the top bits of one word
+            const auto bits = wide ? static_cast<uint64_t>(U8_CONCAT(MemoryAt<profile>(address + i * 2),
+                                                                     MemoryAt<profile>(address + i * 2 + 1)))
+                                         << 48
+                                   : static_cast<uint64_t>(MemoryAt<profile>(address + i)) << 56;
+            const auto line = (py + i) & (height - 1);
+
+            if (!large)
+            {
+                // Pixels past the right edge shift out or rotate around
+                const uint64_t row = quirks.spritesWrap ? std::rotr(bits, px) : bits >> px;
+                auto& word = bitboard[line];
+
+                // Screen pixel also on - collision
+                if (word & row)
+                {
+                    regs[15] = 1;
+                }
+
+                word ^= row;
+                continue;
+            }
+
+            // 128-pixel row: the sprite lands in one word or straddles both, and only wraps from the right one
+            uint64_t left;
+            uint64_t right;
+            if (px < 64)
+            {
+                left = bits >> px;
+                right = px ? bits << (64 - px) : 0;
+            }
+            else
+            {
+                left = quirks.spritesWrap && px > 64 ? bits << (128 - px) : 0;
+                right = bits >> (px - 64);
+            }
+            auto* words = &bitboard[line * 2];
+            if ((words[0] & left) | (words[1] & right))
+            {
+                regs[15] = 1;
+            }
+            words[0] ^= left;
+            words[1] ^= right;
+        }
+        address += wide ? 32 : rows;
+    }
+}
+
+void Chip8::Clear()
+{
+    for (int plane = 0; plane < planeCount; plane++)
+    {
+        if (planeMask & (1 << plane))
+        {
+            std::memset(display[plane], 0, sizeof(display[plane]));
+        }
+    }
+}
+
+void Chip8::ScrollDown(int rows)
+{
+    rows = std::min(rows, DisplayHeight());
+    const auto pitch = DisplayWidth() / 64;
+    for (int plane = 0; plane < planeCount; plane++)
+    {
+        if (planeMask & (1 << plane))
+        {
+            auto* bitboard = display[plane];
+            std::memmove(&bitboard[rows * pitch], bitboard, (DisplayHeight() - rows) * pitch * sizeof(uint64_t));
+            std::memset(bitboard, 0, rows * pitch * sizeof(uint64_t));
+        }
+    }
+}
+
+void Chip8::ScrollUp(int rows)
+{
+    rows = std::min(rows, DisplayHeight());
+    const auto pitch = DisplayWidth() / 64;
+    for (int plane = 0; plane < planeCount; plane++)
+    {
+        if (planeMask & (1 << plane))
+        {
+            auto* bitboard = display[plane];
+            std::memmove(bitboard, &bitboard[rows * pitch], (DisplayHeight() - rows) * pitch * sizeof(uint64_t));
+            std::memset(&bitboard[(DisplayHeight() - rows) * pitch], 0, rows * pitch * sizeof(uint64_t));
+        }
+    }
+}
+
+void Chip8::ScrollRight()
+{
+    for (int plane = 0; plane < planeCount; plane++)
+    {
+        if (!(planeMask & (1 << plane)))
+        {
+            continue;
+        }
+        auto* bitboard = display[plane];
+        if (!hires)
+        {
+            for (int y = 0; y < chip8Height; y++)
+            {
+                bitboard[y] >>= 4;
+            }
+            continue;
+        }
+        for (int y = 0; y < hiresHeight; y++)
+        {
+            auto* words = &bitboard[y * 2];
+            words[1] = (words[1] >> 4) | (words[0] << 60);
+            words[0] >>= 4;
+        }
+    }
+}
+
+void Chip8::ScrollLeft()
+{
+    for (int plane = 0; plane < planeCount; plane++)
+    {
+        if (!(planeMask & (1 << plane)))
+        {
+            continue;
+        }
+        auto* bitboard = display[plane];
+        if (!hires)
+        {
+            for (int y = 0; y < chip8Height; y++)
+            {
+                bitboard[y] <<= 4;
+            }
+            continue;
+        }
+        for (int y = 0; y < hiresHeight; y++)
+        {
+            auto* words = &bitboard[y * 2];
+            words[0] = (words[0] << 4) | (words[1] >> 60);
+            words[1] <<= 4;
+        }
+    }
+}
+
+void Chip8::SetHires(bool enabled)
+{
+    // Rows change length, what was drawn before has no meaning in the new layout
+    hires = enabled;
+    std::memset(display, 0, sizeof(display));
+}
+
+void Chip8::ExecuteNext() { ExecuteNext<QuirkProfile::Default>(); }
+
+void Chip8::Run(QuirkProfile profile, int count)
+{
+    auto run = [&]<QuirkProfile p>()
+    {
+        for (int i = 0; i < count; i++)
+        {
+            ExecuteNext<p>();
+        }
+    };
+
+    switch (profile)
+    {
+    case QuirkProfile::Cosmac:
+        run.operator()<QuirkProfile::Cosmac>();
+        break;
+    case QuirkProfile::SuperChip:
+        run.operator()<QuirkProfile::SuperChip>();
+        break;
+    case QuirkProfile::XoChip:
+        run.operator()<QuirkProfile::XoChip>();
+        break;
+    default:
+        run.operator()<QuirkProfile::Default>();
+        break;
+    }
+}
+
+template void Chip8::ExecuteNext<QuirkProfile::Default>();
+template void Chip8::ExecuteNext<QuirkProfile::Cosmac>();
+template void Chip8::ExecuteNext<QuirkProfile::SuperChip>();
+template void Chip8::ExecuteNext<QuirkProfile::XoChip>();
+template void Chip8::DrawSprite<QuirkProfile::Default>(uint8_t x, uint8_t y, int n);
+template void Chip8::DrawSprite<QuirkProfile::Cosmac>(uint8_t x, uint8_t y, int n);
+template void Chip8::DrawSprite<QuirkProfile::SuperChip>(uint8_t x, uint8_t y, int n);
+template void Chip8::DrawSprite<QuirkProfile::XoChip>(uint8_t x, uint8_t y, int n);
+
+const char* PendingFault(const Chip8& chip8, QuirkProfile profile)
+{
+    // Only xochip with high memory attached has room for code past 4 KiB
+    const auto lastInstruction = QuirksOf(profile).xoChip && chip8.highMemory != nullptr ? xoMemorySize - 2
+                                                                                          : chip8MemorySize - 2;
+    const auto opcode = chip8.NextOpcode(profile);
+    if (chip8.pc < romStartAddress || chip8.pc > lastInstruction)
+    {
+        return "pc outside the program";
+    }
+    if (ClassifyOpcode(opcode, profile) == OpcodeClass::Unknown)
+    {
+        return "unknown opcode";
+    }
+    if (ClassifyOpcode(opcode, profile) == OpcodeClass::Ret && chip8.sp == 0)
+    {
+        return "stack underflow";
+    }
+    if ((opcode >> 12) == 2 && chip8.sp == stackSize)
+    {
+        return "stack overflow";
+    }
+    return nullptr;
+}
+
+void Chip8::SetKey(int key, bool pressed)
+{
+    const uint16_t mask = 1 << (key & 0xf);
+    input = pressed ? (input | mask) : (input & ~mask);
+}
+
+bool Chip8::KeyDown(int key) const { return READ_BIT(input, key & 0xf); }
+
+uint64_t Chip8::Hash() const
+{
+    uint64_t regWords[2];
+    std::memcpy(regWords, regs, sizeof(regs));
+
+    uint64_t h = hashMix(0, regWords[0]);
+    h = hashMix(h, regWords[1]);
+    h = hashMix(h, pc | (static_cast<uint64_t>(ri) << 16) | (static_cast<uint64_t>(rdelay) << 32) |
+                       (static_cast<uint64_t>(rsound) << 40) | (static_cast<uint64_t>(sp) << 48) |
+                       (static_cast<uint64_t>(hires) << 56) | (static_cast<uint64_t>(planeMask) << 57));
+    h = hashMix(h, pitch);
+    h = hashMix(h, input | (static_cast<uint64_t>(rng) << 16));
+
+    for (int i = 0; i < stackSize; i += 4)
+    {
+        h = hashMix(h, stack[i] | (static_cast<uint64_t>(stack[i + 1]) << 16) |
+                           (static_cast<uint64_t>(stack[i + 2]) << 32) | (static_cast<uint64_t>(stack[i + 3]) << 48));
+    }
+
+    uint64_t patternWords[2];
+    std::memcpy(patternWords, audioPattern, sizeof(audioPattern));
+    h = hashMix(hashMix(h, patternWords[0]), patternWords[1]);
+
+    // Four independent lanes so the multiplies overlap
+    uint64_t lanes[4] = {h, h ^ 1, h ^ 2, h ^ 3};
+    for (size_t i = 0; i < sizeof(memory); i += 32)
+    {
+        uint64_t words[4];
+        std::memcpy(words, &memory[i], sizeof(words));
+        for (int lane = 0; lane < 4; lane++)
+        {
+            lanes[lane] = hashMix(lanes[lane], words[lane]);
+        }
+    }
+    for (size_t i = 0; highMemory != nullptr && i < highMemorySize; i += 32)
+    {
+        uint64_t words[4];
+        std::memcpy(words, &highMemory[i], sizeof(words));
+        // Most XO-CHIP programs leave nearly all of it zero, those chunks only cost the test. The offset keeps the
+        // same bytes at different addresses apart.
+        if ((words[0] | words[1] | words[2] | words[3]) == 0)
+        {
+            continue;
+        }
+        lanes[0] = hashMix(lanes[0], i);
+        for (int lane = 0; lane < 4; lane++)
+        {
+            lanes[lane] = hashMix(lanes[lane], words[lane]);
+        }
+    }
+    for (const auto& bitboard : display)
+    {
+        for (int word = 0; word < displayWords; word += 4)
+        {
+            for (int lane = 0; lane < 4; lane++)
+            {
+                lanes[lane] = hashMix(lanes[lane], bitboard[word + lane]);
+            }
+        }
+    }
+
+    return hashMix(hashMix(lanes[0], lanes[1]), hashMix(lanes[2], lanes[3]));
+}
+
+void Chip8::RenderVideo(uint32_t (&videoBuffer)[hiresWidth * hiresHeight]) const
+{
+    const auto width = DisplayWidth();
+    for (int y = 0; y < DisplayHeight(); y++)
+    {
+        const auto* first = DisplayRow(y, 0);
+        const auto* second = DisplayRow(y, 1);
+        for (int x = 0; x < width; x++)
+        {
+            const auto shift = 63 - x % 64;
+            const auto lit = ((first[x / 64] >> shift) & 1) | (((second[x / 64] >> shift) & 1) << 1);
+            videoBuffer[y * width + x] = planeColors[lit];
+        }
+    }
+}
@@ -1,15 +1,25 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#include <random>
-#include <stack>
+#include <span>
 #include <string>
+#include <type_traits>
 
 #include "bit.h"
 
+// Low resolution, the only mode of the base instruction set
 constexpr int chip8Width = 64;
 constexpr int chip8Height = 32;
 
+// SUPER-CHIP high resolution, selected by 00FF
+constexpr int hiresWidth = 128;
+constexpr int hiresHeight = 64;
+// 64 pixels per word, sized for the larger mode
+constexpr int displayWords = hiresWidth * hiresHeight / 64;
+// XO-CHIP bit planes, plane 0 is the only one the other profiles draw to
+constexpr int planeCount = 2;
+
 constexpr int spriteCount = 15;
 constexpr int spriteSize = 5;
 constexpr uint8_t spriteStartAddress = 0x50;
@@ -33,29 +43,245 @@ constexpr uint8_t fontset[80] = {
     0xF0, 0x80, 0xF0, 0x80, 0x80   // F
 };
 
-constexpr int inputKeyCount = 15;
+// Address space of the base instruction set, addresses wrap at its end
+constexpr int chip8MemorySize = 4096;
+// XO-CHIP addresses 64 KiB, the part above chip8MemorySize lives in an XoChip8
+constexpr int xoMemorySize = 65536;
+constexpr int highMemorySize = xoMemorySize - chip8MemorySize;
+
+constexpr uint16_t romStartAddress = 0x200;
+constexpr int maxRomSize = chip8MemorySize - romStartAddress;
+constexpr int xoMaxRomSize = xoMemorySize - romStartAddress;
+
+constexpr int inputKeyCount = 16;
+constexpr int stackSize = 16;
+
+// Instructions executed per 60Hz frame
+constexpr int cyclesPerFrame = 10;
+
+constexpr uint32_t pixelColor = 0x0000ff00;
+// Indexed by the lit planes of a pixel, bit N for plane N
+constexpr uint32_t planeColors[1 << planeCount] = {0, pixelColor, 0x00ff6600, 0x00ffcc00};
+
+// XO-CHIP audio: F002 loads 16 bytes of 1-bit samples, FX3A sets the pitch they play at
+constexpr int audioPatternSize = 16;
+constexpr uint8_t defaultPitch = 64;
+
+enum class RomError : uint8_t
+{
+    None,
+    OpenFailed,
+    ReadFailed,
+    TooLarge,
+};
+
+[[nodiscard]] const char* RomErrorMessage(RomError error);
+
+// Behaviours that differ between CHIP-8 implementations
+struct Quirks
+{
+    // 8XY6/8XYE shift VY into VX, otherwise VX is shifted in place
+    bool shiftReadsVy;
+    // FX55/FX65 leave I pointing past the last register transferred
+    bool loadStoreAdvancesI;
+    // BXNN jumps to XNN + VX instead of BNNN jumping to NNN + V0
+    bool jumpAddsVx;
+    // 8XY1/8XY2/8XY3 clear VF
+    bool logicClearsVf;
+    // DXYN wraps pixels past the edges around instead of clipping them
+    bool spritesWrap;
+    // SUPER-CHIP display instructions: 00CN/00FB/00FC scroll, 00FE/00FF switch between 64x32 and 128x64, DXY0 draws
+    // a 16x16 sprite. Without them those opcodes keep the base interpreter's behaviour.
+    bool schipDisplay;
+    // XO-CHIP: 64 KiB of addresses, F000 NNNN long I loads, FN01 plane select, 00DN scroll up, 5XY2/5XY3 register
+    // ranges, F002/FX3A audio. Skips step over F000 NNNN as one instruction.
+    bool xoChip;
+};
+
+enum class QuirkProfile : uint8_t
+{
+    // What this interpreter has always done
+    Default,
+    Cosmac,
+    SuperChip,
+    XoChip,
+};
+
+constexpr int quirkProfileCount = 4;
+
+constexpr Quirks QuirksOf(QuirkProfile profile)
+{
+    switch (profile)
+    {
+    case QuirkProfile::Cosmac:
+        return {.shiftReadsVy = true, .loadStoreAdvancesI = true, .logicClearsVf = true};
+    case QuirkProfile::SuperChip:
+        return {.jumpAddsVx = true, .schipDisplay = true};
+    case QuirkProfile::XoChip:
+        return {.shiftReadsVy = true, .loadStoreAdvancesI = true, .spritesWrap = true, .schipDisplay = true,
+                .xoChip = true};
+    default:
+        return {.shiftReadsVy = true};
+    }
+}
+
+// Largest image LoadRom takes for a profile
+constexpr int MaxRomSize(QuirkProfile profile) { return QuirksOf(profile).xoChip ? xoMaxRomSize : maxRomSize; }
 
+[[nodiscard]] const char* QuirkProfileName(QuirkProfile profile);
+// Accepts the names returned by QuirkProfileName
+[[nodiscard]] bool ParseQuirkProfile(const std::string& name, QuirkProfile& profile);
+
+// Machine state is a plain value: copying a Chip8 is a complete snapshot. The one exception is XO-CHIP high memory,
+// which is not part of the value, copy the XoChip8 that owns it instead.
 struct Chip8
 {
     // General purpose registers
     // reg[15] = flag register
-    uint8_t regs[16];
+    uint8_t regs[16]{};
 
     // Special registers
-    uint16_t pc;
-    uint16_t ri;
-    uint8_t rdelay;
-    uint8_t rsound;
+    uint16_t pc{};
+    uint16_t ri{};
+    uint8_t rdelay{};
+    uint8_t rsound{};
+
+    // sp is the next free slot of stack
+    uint8_t sp{};
+    uint16_t stack[stackSize]{};
+
+    // Pressed keys, bit N set = key N down
+    uint16_t input{};
+
+    // xorshift32 state used by CXNN
+    uint32_t rng{};
+
+    // Instructions that found a timer running and ticked it, wraps around. Counted for the frontend's timer drift and
+    // left out of Hash().
+    uint32_t timerTicks{};
 
-    uint8_t memory[4096]{};
-    uint32_t videoBuffer[chip8Width * chip8Height]{};
+    // The other profiles wrap addresses at chip8MemorySize, XO-CHIP goes on into highMemory
+    uint8_t memory[chip8MemorySize]{};
+    // The 60 KiB above memory, set by the XoChip8 owning them. Without it XO-CHIP wraps at 4 KiB too.
+    uint8_t* highMemory{};
 
-    std::stack<uint16_t> stack;
+    // One bitboard per plane, composited to colour by RenderVideo. Rows of DisplayWidth() / 64 words, bit 63 of a
+    // row's first word is its leftmost pixel. Low resolution rows are one word each, so the 64x32 screen is the first
+    // chip8Height words.
+    uint64_t display[planeCount][displayWords]{};
+    // 128x64 mode, switching clears the display
+    bool hires{};
+    // Planes drawn, cleared and scrolled, bit N for plane N. FN01 sets it, it stays 1 outside XO-CHIP.
+    uint8_t planeMask{1};
 
-    bool input[15];
+    // 128 samples, most significant bit first. They play at 4000 * 2^((pitch - 64) / 48) samples per second while the
+    // sound timer runs.
+    uint8_t audioPattern[audioPatternSize]{};
+    uint8_t pitch{defaultPitch};
 
     Chip8();
+    explicit Chip8(uint32_t seed);
 
-    bool LoadRom(const std::string& path);
+    // Reads the file in one call, see ReadRomFile in rom.h
+    RomError LoadRom(const std::string& path, QuirkProfile profile = QuirkProfile::Default);
+    // Copy an image to romStartAddress and clear the rest of the program area, high memory included. Fails if it is
+    // larger than MaxRomSize(profile), or than maxRomSize without high memory.
+    RomError LoadRom(std::span<const uint8_t> image, QuirkProfile profile = QuirkProfile::Default);
+    // Runs one instruction with the Default profile
     void ExecuteNext();
+    // One interpreter is compiled per profile, quirks cost nothing at run time
+    template <QuirkProfile profile>
+    void ExecuteNext();
+    // Picks the interpreter for profile once and runs count instructions with it
+    void Run(QuirkProfile profile, int count);
+
+    // DXYN with the sprite at column x, row y: XORs n rows from I into the display and sets VF on collision. Rows are
+    // moved as whole words, also for 16x16 sprites and in high resolution. XO-CHIP draws into every selected plane,
+    // the sprite for the second one following the first in memory.
+    template <QuirkProfile profile>
+    void DrawSprite(uint8_t x, uint8_t y, int n);
+    // 00E0 on the selected planes
+    void Clear();
+    // Scrolling of the selected planes, shifting row words: 00CN/00DN move them down/up n rows, 00FB/00FC 4 pixels
+    // right/left
+    void ScrollDown(int rows);
+    void ScrollUp(int rows);
+    void ScrollRight();
+    void ScrollLeft();
+    // 00FF/00FE, clears every plane
+    void SetHires(bool enabled);
+
+    [[nodiscard]] int DisplayWidth() const { return hires ? hiresWidth : chip8Width; }
+    [[nodiscard]] int DisplayHeight() const { return hires ? hiresHeight : chip8Height; }
+    // First of the DisplayWidth() / 64 words of row y
+    [[nodiscard]] const uint64_t* DisplayRow(int y, int plane = 0) const
+    {
+        return &display[plane][y * (DisplayWidth() / 64)];
+    }
+
+    // Byte at address as profile addresses it
+    template <QuirkProfile profile>
+    [[nodiscard]] uint8_t& MemoryAt(unsigned address)
+    {
+        if constexpr (QuirksOf(profile).xoChip)
+        {
+            address &= xoMemorySize - 1;
+            if (address >= chip8MemorySize && highMemory != nullptr)
+            {
+                return highMemory[address - chip8MemorySize];
+            }
+        }
+        return memory[address & (chip8MemorySize - 1)];
+    }
+    template <QuirkProfile profile>
+    [[nodiscard]] uint8_t MemoryAt(unsigned address) const
+    {
+        return const_cast<Chip8*>(this)->MemoryAt<profile>(address);
+    }
+
+    // Addresses profile reaches in this machine: all 64 KiB for xochip with high memory attached, 4 KiB otherwise
+    [[nodiscard]] int MemorySize(QuirkProfile profile) const
+    {
+        return QuirksOf(profile).xoChip && highMemory != nullptr ? xoMemorySize : chip8MemorySize;
+    }
+
+    // Opcode at pc as profile fetches it, wrapped at 4 KiB or from high memory
+    [[nodiscard]] uint16_t NextOpcode(QuirkProfile profile) const
+    {
+        if (QuirksOf(profile).xoChip)
+        {
+            return U8_CONCAT(MemoryAt<QuirkProfile::XoChip>(pc), MemoryAt<QuirkProfile::XoChip>(pc + 1));
+        }
+        return U8_CONCAT(memory[pc & 0xfff], memory[(pc + 1) & 0xfff]);
+    }
+
+    void SetKey(int key, bool pressed);
+    [[nodiscard]] bool KeyDown(int key) const;
+
+    // 64-bit hash of the whole machine state, used to dedup snapshots
+    [[nodiscard]] uint64_t Hash() const;
+
+    // Composite the planes into one 0x00RRGGBB value per pixel from planeColors, DisplayWidth() x DisplayHeight() of
+    // them
+    void RenderVideo(uint32_t (&videoBuffer)[hiresWidth * hiresHeight]) const;
+};
+
+static_assert(std::is_trivially_copyable_v<Chip8>, "Chip8 must stay snapshot-able by plain copy");
+
+// A Chip8 with the memory XO-CHIP reaches above chip8MemorySize. Copies point their chip8 at their own high memory,
+// so copying an XoChip8 is the complete snapshot.
+struct XoChip8
+{
+    Chip8 chip8;
+    uint8_t highMemory[highMemorySize]{};
+
+    XoChip8() { chip8.highMemory = highMemory; }
+    explicit XoChip8(uint32_t seed) : chip8(seed) { chip8.highMemory = highMemory; }
+    XoChip8(const XoChip8& other);
+    XoChip8& operator=(const XoChip8& other);
 };
+
+// Why the next instruction would not run as a program intends it under profile (an opcode the profile does not know,
+// pc outside the program or past the memory the profile has, stack under/overflow), nullptr if it is fine. The
+// interpreter itself carries on regardless.
+[[nodiscard]] const char* PendingFault(const Chip8& chip8, QuirkProfile profile);
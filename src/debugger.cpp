@@ -0,0 +1,164 @@
+#include "debugger.h"
+
+#include <algorithm>
+
+#include "opcode.h"
+
+namespace
+{
+uint16_t registerValue(const Chip8& chip8, int index) { return index == watchRegisterI ? chip8.ri : chip8.regs[index]; }
+
+// No StepOver in progress
+constexpr int noReturnDepth = -1;
+}  // namespace
+
+void Debugger::SetBreakpoint(uint16_t address) { breakpoints.set(address); }
+
+void Debugger::ClearBreakpoint(uint16_t address) { breakpoints.reset(address); }
+
+void Debugger::WatchMemory(uint16_t address)
+{
+    if (std::find(memoryWatches.begin(), memoryWatches.end(), address) == memoryWatches.end())
+    {
+        memoryWatches.push_back(address);
+    }
+}
+
+void Debugger::UnwatchMemory(uint16_t address)
+{
+    std::erase(memoryWatches, address);
+}
+
+void Debugger::WatchRegister(int index)
+{
+    if (index >= 0 && index <= watchRegisterI)
+    {
+        registerWatches.set(index);
+    }
+}
+
+void Debugger::UnwatchRegister(int index)
+{
+    if (index >= 0 && index <= watchRegisterI)
+    {
+        registerWatches.reset(index);
+    }
+}
+
+std::vector<uint16_t> Debugger::Breakpoints() const
+{
+    std::vector<uint16_t> addresses;
+    for (size_t address = 0; address < breakpoints.size(); address++)
+    {
+        if (breakpoints[address])
+        {
+            addresses.push_back(static_cast<uint16_t>(address));
+        }
+    }
+    return addresses;
+}
+
+template <QuirkProfile profile>
+DebugStop Debugger::runChecked(Chip8& chip8, int count, int returnDepth)
+{
+    // pc is fetched modulo the memory the profile reaches, a power of two. Watched bytes past it never change.
+    const auto memorySize = chip8.MemorySize(profile);
+    const auto watched = [&](uint16_t address) -> uint8_t
+    { return address < memorySize ? chip8.MemoryAt<profile>(address) : 0; };
+
+    // Watched values are kept between instructions instead of snapshotting the machine
+    std::vector<uint8_t> memoryValues(memoryWatches.size());
+    for (size_t i = 0; i < memoryWatches.size(); i++)
+    {
+        memoryValues[i] = watched(memoryWatches[i]);
+    }
+    uint16_t registerValues[watchRegisterI + 1];
+    for (int index = 0; index <= watchRegisterI; index++)
+    {
+        registerValues[index] = registerValue(chip8, index);
+    }
+
+    const auto returnAddress = static_cast<uint16_t>(chip8.pc + 2);
+    DebugStop stop;
+    for (; stop.executed < count; stop.executed++)
+    {
+        if (stop.executed > 0 && breakpoints[chip8.pc & (memorySize - 1)])
+        {
+            stop.reason = StopReason::Breakpoint;
+            return stop;
+        }
+
+        chip8.ExecuteNext<profile>();
+
+        for (size_t i = 0; i < memoryWatches.size(); i++)
+        {
+            if (watched(memoryWatches[i]) != memoryValues[i])
+            {
+                stop = {StopReason::Watchpoint, stop.executed + 1, false, memoryWatches[i], memoryValues[i],
+                        watched(memoryWatches[i])};
+                return stop;
+            }
+        }
+        for (int index = 0; index <= watchRegisterI; index++)
+        {
+            if (registerWatches[index] && registerValue(chip8, index) != registerValues[index])
+            {
+                stop = {StopReason::Watchpoint, stop.executed + 1, true, static_cast<uint16_t>(index),
+                        registerValues[index], registerValue(chip8, index)};
+                return stop;
+            }
+        }
+
+        if (returnDepth != noReturnDepth && chip8.sp == returnDepth && chip8.pc == returnAddress)
+        {
+            stop.executed++;
+            stop.reason = StopReason::Step;
+            return stop;
+        }
+    }
+    return stop;
+}
+
+DebugStop Debugger::dispatch(Chip8& chip8, QuirkProfile profile, int count, int returnDepth)
+{
+    switch (profile)
+    {
+    case QuirkProfile::Cosmac:
+        return runChecked<QuirkProfile::Cosmac>(chip8, count, returnDepth);
+    case QuirkProfile::SuperChip:
+        return runChecked<QuirkProfile::SuperChip>(chip8, count, returnDepth);
+    case QuirkProfile::XoChip:
+        return runChecked<QuirkProfile::XoChip>(chip8, count, returnDepth);
+    default:
+        return runChecked<QuirkProfile::Default>(chip8, count, returnDepth);
+    }
+}
+
+DebugStop Debugger::Run(Chip8& chip8, QuirkProfile profile, int count)
+{
+    if (!Active())
+    {
+        chip8.Run(profile, count);
+        return {StopReason::None, count};
+    }
+    return dispatch(chip8, profile, count, noReturnDepth);
+}
+
+DebugStop Debugger::Step(Chip8& chip8, QuirkProfile profile)
+{
+    auto stop = dispatch(chip8, profile, 1, noReturnDepth);
+    if (stop.reason == StopReason::None)
+    {
+        stop.reason = StopReason::Step;
+    }
+    return stop;
+}
+
+DebugStop Debugger::StepOver(Chip8& chip8, QuirkProfile profile, int limit)
+{
+    if (ClassifyOpcode(chip8.NextOpcode(profile), profile) != OpcodeClass::Call)
+    {
+        return Step(chip8, profile);
+    }
+    return dispatch(chip8, profile, limit, chip8.sp);
+}
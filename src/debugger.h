@@ -0,0 +1,79 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+#include "chip8.h"
+
+// Register index used to watch I next to V0..VF
+constexpr int watchRegisterI = 16;
+
+enum class StopReason
+{
+    // Ran the requested number of instructions
+    None,
+    Breakpoint,
+    Watchpoint,
+    // Step finished, or StepOver got back to the instruction after the call
+    Step,
+};
+
+struct DebugStop
+{
+    StopReason reason = StopReason::None;
+    // Instructions executed before stopping
+    int executed = 0;
+    // Watchpoint hit: the memory address or register index and its value before and after
+    bool registerWatch = false;
+    uint16_t location = 0;
+    uint16_t before = 0;
+    uint16_t after = 0;
+};
+
+// Breakpoints on pc and watchpoints on memory bytes and registers.
+//
+// Addresses span the 64 KiB of XO-CHIP. The part past Chip8::MemorySize of the profile a run uses is never executed
+// or changed, breakpoints and watches there do not fire.
+//
+// With nothing set Run is Chip8::Run, the plain interpreter. Otherwise it steps through a checked loop compiled once
+// per quirk profile that tests the breakpoint set before and the watched values after every instruction.
+class Debugger
+{
+public:
+    void SetBreakpoint(uint16_t address);
+    void ClearBreakpoint(uint16_t address);
+    [[nodiscard]] bool HasBreakpoint(uint16_t address) const { return breakpoints[address]; }
+
+    void WatchMemory(uint16_t address);
+    void UnwatchMemory(uint16_t address);
+    // 0..15 for V0..VF, watchRegisterI for I
+    void WatchRegister(int index);
+    void UnwatchRegister(int index);
+
+    [[nodiscard]] bool Active() const { return breakpoints.any() || !memoryWatches.empty() || registerWatches.any(); }
+
+    [[nodiscard]] const std::vector<uint16_t>& MemoryWatches() const { return memoryWatches; }
+    [[nodiscard]] const std::bitset<watchRegisterI + 1>& RegisterWatches() const { return registerWatches; }
+    [[nodiscard]] std::vector<uint16_t> Breakpoints() const;
+
+    // Runs up to count instructions. A breakpoint on the pc the run starts from is ignored, so calling Run again
+    // after a breakpoint stop continues past it.
+    DebugStop Run(Chip8& chip8, QuirkProfile profile, int count);
+
+    // One instruction, watchpoints still report
+    DebugStop Step(Chip8& chip8, QuirkProfile profile);
+
+    // Like Step, but a 2NNN runs until the subroutine returns to the next instruction, or at most limit instructions
+    DebugStop StepOver(Chip8& chip8, QuirkProfile profile, int limit);
+
+private:
+    template <QuirkProfile profile>
+    DebugStop runChecked(Chip8& chip8, int count, int returnDepth);
+
+    DebugStop dispatch(Chip8& chip8, QuirkProfile profile, int count, int returnDepth);
+
+    std::bitset<xoMemorySize> breakpoints;
+    std::vector<uint16_t> memoryWatches;
+    std::bitset<watchRegisterI + 1> registerWatches;
+};
@@ -0,0 +1,113 @@
+#include "disasm.h"
+
+#include <format>
+
+#include "opcode.h"
+
+std::string Disassemble(uint16_t opcode, QuirkProfile profile)
+{
+    const auto x = (opcode >> 8) & 0xf;
+    const auto y = (opcode >> 4) & 0xf;
+    const auto n = opcode & 0xf;
+    const auto nn = opcode & 0xff;
+    const auto nnn = opcode & 0xfff;
+
+    switch (ClassifyOpcode(opcode, profile))
+    {
+    case OpcodeClass::Cls:
+        return "CLS";
+    case OpcodeClass::Ret:
+        return "RET";
+    case OpcodeClass::Jump:
+        return std::format("JP 0x{:03x}", nnn);
+    case OpcodeClass::Call:
+        return std::format("CALL 0x{:03x}", nnn);
+    case OpcodeClass::SkipEqImm:
+        return std::format("SE V{:X}, 0x{:02x}", x, nn);
+    case OpcodeClass::SkipNeImm:
+        return std::format("SNE V{:X}, 0x{:02x}", x, nn);
+    case OpcodeClass::SkipEqReg:
+        return std::format("SE V{:X}, V{:X}", x, y);
+    case OpcodeClass::LoadImm:
+        return std::format("LD V{:X}, 0x{:02x}", x, nn);
+    case OpcodeClass::AddImm:
+        return std::format("ADD V{:X}, 0x{:02x}", x, nn);
+    case OpcodeClass::Move:
+        return std::format("LD V{:X}, V{:X}", x, y);
+    case OpcodeClass::Or:
+        return std::format("OR V{:X}, V{:X}", x, y);
+    case OpcodeClass::And:
+        return std::format("AND V{:X}, V{:X}", x, y);
+    case OpcodeClass::Xor:
+        return std::format("XOR V{:X}, V{:X}", x, y);
+    case OpcodeClass::Add:
+        return std::format("ADD V{:X}, V{:X}", x, y);
+    case OpcodeClass::Sub:
+        return std::format("SUB V{:X}, V{:X}", x, y);
+    case OpcodeClass::ShiftRight:
+        return std::format("SHR V{:X}, V{:X}", x, y);
+    case OpcodeClass::SubReverse:
+        return std::format("SUBN V{:X}, V{:X}", x, y);
+    case OpcodeClass::ShiftLeft:
+        return std::format("SHL V{:X}, V{:X}", x, y);
+    case OpcodeClass::SkipNeReg:
+        return std::format("SNE V{:X}, V{:X}", x, y);
+    case OpcodeClass::LoadI:
+        return std::format("LD I, 0x{:03x}", nnn);
+    case OpcodeClass::JumpOffset:
+        return std::format("JP V0, 0x{:03x}", nnn);
+    case OpcodeClass::Random:
+        return std::format("RND V{:X}, 0x{:02x}", x, nn);
+    case OpcodeClass::Draw:
+        return std::format("DRW V{:X}, V{:X}, {}", x, y, n);
+    case OpcodeClass::SkipKey:
+        return std::format("SKP V{:X}", x);
+    case OpcodeClass::SkipNoKey:
+        return std::format("SKNP V{:X}", x);
+    case OpcodeClass::GetDelay:
+        return std::format("LD V{:X}, DT", x);
+    case OpcodeClass::WaitKey:
+        return std::format("LD V{:X}, K", x);
+    case OpcodeClass::SetDelay:
+        return std::format("LD DT, V{:X}", x);
+    case OpcodeClass::SetSound:
+        return std::format("LD ST, V{:X}", x);
+    case OpcodeClass::AddI:
+        return std::format("ADD I, V{:X}", x);
+    case OpcodeClass::Font:
+        return std::format("LD F, V{:X}", x);
+    case OpcodeClass::Bcd:
+        return std::format("LD B, V{:X}", x);
+    case OpcodeClass::Store:
+        return std::format("LD [I], V{:X}", x);
+    case OpcodeClass::Load:
+        return std::format("LD V{:X}, [I]", x);
+    case OpcodeClass::ScrollDown:
+        return std::format("SCD {}", n);
+    case OpcodeClass::ScrollRight:
+        return "SCR";
+    case OpcodeClass::ScrollLeft:
+        return "SCL";
+    case OpcodeClass::LowRes:
+        return "LOW";
+    case OpcodeClass::HighRes:
+        return "HIGH";
+    case OpcodeClass::ScrollUp:
+        return std::format("SCU {}", n);
+    case OpcodeClass::SaveRange:
+        return std::format("LD [I], V{:X}-V{:X}", x, y);
+    case OpcodeClass::LoadRange:
+        return std::format("LD V{:X}-V{:X}, [I]", x, y);
+    case OpcodeClass::LoadILong:
+        // The address is the next word
+        return "LD I, LONG";
+    case OpcodeClass::Planes:
+        return std::format("PLANE {}", x);
+    case OpcodeClass::Audio:
+        return "AUDIO";
+    case OpcodeClass::Pitch:
+        return std::format("PITCH V{:X}", x);
+    default:
+        return std::format("DW 0x{:04x}", opcode);
+    }
+}
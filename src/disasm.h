@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "chip8.h"
+
+// Mnemonic in the usual CHIP-8 assembler syntax, e.g. "ADD V3, 0x01" or "DRW V0, V1, 5". Opcodes profile does not
+// know come out as data: "DW 0x0123".
+[[nodiscard]] std::string Disassemble(uint16_t opcode, QuirkProfile profile);
@@ -0,0 +1,78 @@
+#include "file_watch.h"
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <climits>
+#endif
+
+FileWatcher::~FileWatcher()
+{
+#if defined(__linux__)
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+#endif
+}
+
+bool FileWatcher::Watch(const std::string& file)
+{
+    std::error_code error;
+    path = std::filesystem::absolute(file, error);
+    if (error)
+    {
+        return false;
+    }
+
+#if defined(__linux__)
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+    watch = inotify_add_watch(fd, path.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    return watch >= 0;
+#else
+    lastWrite = std::filesystem::last_write_time(path, error);
+    return !error;
+#endif
+}
+
+bool FileWatcher::Changed()
+{
+#if defined(__linux__)
+    if (watch < 0)
+    {
+        return false;
+    }
+
+    // Drain everything queued, a rebuild usually produces several events
+    bool changed = false;
+    alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+    ssize_t length;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0 && path.filename() == event->name)
+            {
+                changed = true;
+            }
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+    return changed;
+#else
+    std::error_code error;
+    const auto write = std::filesystem::last_write_time(path, error);
+    if (error || write == lastWrite)
+    {
+        return false;
+    }
+    lastWrite = write;
+    return true;
+#endif
+}
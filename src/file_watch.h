@@ -0,0 +1,29 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+// Reports when a file has been rewritten. Uses inotify on Linux, elsewhere compares the modification time.
+//
+// The containing directory is watched rather than the file, so editors and build tools that replace the file by
+// renaming a new one over it are seen as well.
+class FileWatcher
+{
+public:
+    FileWatcher() = default;
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    [[nodiscard]] bool Watch(const std::string& path);
+
+    // Non-blocking, true once per batch of changes since the last call
+    [[nodiscard]] bool Changed();
+
+private:
+    std::filesystem::path path;
+    int fd = -1;
+    int watch = -1;
+    std::filesystem::file_time_type lastWrite{};
+};
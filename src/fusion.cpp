@@ -0,0 +1,292 @@
+#include "fusion.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "analysis.h"
+
+namespace
+{
+// n instructions worth of timer decrements
+void tick(Chip8& chip8, int n)
+{
+    chip8.timerTicks += std::min<int>(n, std::max(chip8.rdelay, chip8.rsound));
+    chip8.rdelay = chip8.rdelay > n ? chip8.rdelay - n : 0;
+    chip8.rsound = chip8.rsound > n ? chip8.rsound - n : 0;
+}
+
+// 3XKK or 4XKK on register x
+bool isSkipImm(uint16_t opcode, int x)
+{
+    return ((opcode >> 12) == 3 || (opcode >> 12) == 4) && ((opcode >> 8) & 0xf) == x;
+}
+
+FusedKind recognise(const uint16_t (&opcodes)[3], uint16_t address)
+{
+    const auto x = (opcodes[0] >> 8) & 0xf;
+    const auto jumpsBack = opcodes[2] == (0x1000 | address);
+    if (opcodes[0] == (0x1000 | address))
+    {
+        return FusedKind::Spin;
+    }
+    if ((opcodes[0] >> 12) == 7 && isSkipImm(opcodes[1], x) && jumpsBack)
+    {
+        return FusedKind::CountedLoop;
+    }
+    if ((opcodes[0] & 0xf0ff) == 0xf007 && isSkipImm(opcodes[1], x) && jumpsBack)
+    {
+        return FusedKind::DelayWait;
+    }
+    return FusedKind::None;
+}
+
+uint8_t lengthOf(FusedKind kind) { return kind == FusedKind::Spin ? 1 : 3; }
+
+// Each returns the instructions it ran, pc is the address of the sequence
+
+// Nothing changes but the timers, the whole count is spent in one go
+int spin(Chip8& chip8, int count)
+{
+    tick(chip8, count);
+    return count;
+}
+
+// Whole iterations while they fit in count, leaves pc on the loop or past it once the skip is taken
+int countedLoop(Chip8& chip8, const FusedOp& op, int count)
+{
+    auto& value = chip8.regs[op.bytes[0] & 0xf];
+    const auto step = op.bytes[1];
+    const auto limit = op.bytes[3];
+    const auto exitOnEqual = (op.bytes[2] >> 4) == 3;
+    int executed = 0;
+    while (true)
+    {
+        value += step;
+        if ((value == limit) == exitOnEqual)
+        {
+            executed += 2;
+            chip8.pc += 6;
+            break;
+        }
+        executed += 3;
+        if (count - executed < 3)
+        {
+            break;
+        }
+    }
+    // Nothing in the loop reads the timers
+    tick(chip8, executed);
+    return executed;
+}
+
+// Iteration k reads max(delay - 3k, 0), one tick per instruction, so the exit is solved for instead of stepped to
+int delayWait(Chip8& chip8, const FusedOp& op, int count)
+{
+    auto& value = chip8.regs[op.bytes[0] & 0xf];
+    const int limit = op.bytes[3];
+    const int delay = chip8.rdelay;
+    const auto exitOnEqual = (op.bytes[2] >> 4) == 3;
+    const auto readAt = [&](int k) { return static_cast<uint8_t>(std::max(delay - 3 * k, 0)); };
+
+    // First iteration that leaves the loop, -1 when it spins until the count runs out
+    int exit = -1;
+    if (exitOnEqual && limit == 0)
+    {
+        exit = (delay + 2) / 3;
+    }
+    else if (exitOnEqual)
+    {
+        exit = delay >= limit && (delay - limit) % 3 == 0 ? (delay - limit) / 3 : -1;
+    }
+    else if (delay != limit)
+    {
+        exit = 0;
+    }
+    else if (delay > 0)
+    {
+        exit = 1;
+    }
+
+    const auto iterations = count / 3;
+    if (exit >= 0 && exit < iterations)
+    {
+        value = readAt(exit);
+        tick(chip8, exit * 3 + 2);
+        chip8.pc += 6;
+        return exit * 3 + 2;
+    }
+    value = readAt(iterations - 1);
+    tick(chip8, iterations * 3);
+    return iterations * 3;
+}
+}  // namespace
+
+const char* FusedKindName(FusedKind kind)
+{
+    switch (kind)
+    {
+    case FusedKind::Spin:
+        return "spin";
+    case FusedKind::CountedLoop:
+        return "counted loop";
+    case FusedKind::DelayWait:
+        return "delay wait";
+    default:
+        return "none";
+    }
+}
+
+FusionTable::FusionTable(const Chip8& chip8, QuirkProfile profile)
+{
+    const auto analysis = AnalyzeProgram(chip8, profile);
+    for (size_t address = romStartAddress; address + 6 <= chip8MemorySize; address++)
+    {
+        if (!analysis.code[address])
+        {
+            continue;
+        }
+        uint16_t opcodes[3];
+        for (int i = 0; i < 3; i++)
+        {
+            opcodes[i] = U8_CONCAT(chip8.memory[address + i * 2], chip8.memory[address + i * 2 + 1]);
+        }
+        const auto kind = recognise(opcodes, static_cast<uint16_t>(address));
+        const auto whole = lengthOf(kind) == 1 || (analysis.code[address + 2] && analysis.code[address + 4]);
+        if (kind == FusedKind::None || !whole)
+        {
+            continue;
+        }
+
+        if (ops.empty())
+        {
+            ops.resize(chip8MemorySize);
+        }
+        auto& op = ops[address];
+        op.kind = kind;
+        op.length = lengthOf(kind);
+        std::memcpy(op.bytes, &chip8.memory[address], op.length * 2);
+        size++;
+    }
+    if (ops.empty())
+    {
+        return;
+    }
+
+    // Fewest instructions from each address to a sequence start along the static control flow, relaxed until stable.
+    // Running that many on the interpreter can never step over a sequence. After 00EE, BNNN or outside the analysed
+    // code the next pc is unknown, so only that one instruction runs before looking again.
+    interpreted.assign(chip8MemorySize, 1);
+    for (const auto& [start, block] : analysis.blocks)
+    {
+        for (auto address = start; address < block.end; address += 2)
+        {
+            interpreted[address] = ops[address].kind != FusedKind::None ? 0 : 255;
+        }
+    }
+    for (auto changed = true; changed;)
+    {
+        changed = false;
+        for (const auto& [start, block] : analysis.blocks)
+        {
+            for (auto address = block.end - 2; address >= start; address -= 2)
+            {
+                if (interpreted[address] == 0)
+                {
+                    continue;
+                }
+                int nearest = block.successors.empty() ? 0 : 254;
+                if (address + 2 < block.end)
+                {
+                    nearest = interpreted[address + 2];
+                }
+                else
+                {
+                    for (const auto successor : block.successors)
+                    {
+                        nearest = std::min<int>(nearest, interpreted[successor]);
+                    }
+                }
+                const auto distance = static_cast<uint8_t>(std::min(nearest + 1, 255));
+                if (distance < interpreted[address])
+                {
+                    interpreted[address] = distance;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+const FusedOp* FusionTable::At(uint16_t address) const
+{
+    return address < ops.size() && ops[address].kind != FusedKind::None ? &ops[address] : nullptr;
+}
+
+template <QuirkProfile profile>
+void FusionTable::run(Chip8& chip8, int count) const
+{
+    while (count > 0)
+    {
+        // Everything up to the nearest sequence runs on the interpreter in one go, without going through Run's
+        // dispatch for each stretch
+        const auto stretch = chip8.pc < interpreted.size() ? interpreted[chip8.pc] : 1;
+        if (stretch > 0)
+        {
+            const auto n = std::min<int>(stretch, count);
+            for (int i = 0; i < n; i++)
+            {
+                chip8.ExecuteNext<profile>();
+            }
+            count -= n;
+            continue;
+        }
+
+        // A rewritten sequence is no longer the one recognised
+        const auto* op = &ops[chip8.pc];
+        if (count < op->length || std::memcmp(op->bytes, &chip8.memory[chip8.pc], op->length * 2) != 0)
+        {
+            chip8.ExecuteNext<profile>();
+            count--;
+            continue;
+        }
+
+        switch (op->kind)
+        {
+        case FusedKind::Spin:
+            count -= spin(chip8, count);
+            break;
+        case FusedKind::CountedLoop:
+            count -= countedLoop(chip8, *op, count);
+            break;
+        default:
+            count -= delayWait(chip8, *op, count);
+            break;
+        }
+    }
+}
+
+void FusionTable::Run(Chip8& chip8, QuirkProfile profile, int count) const
+{
+    if (ops.empty())
+    {
+        chip8.Run(profile, count);
+        return;
+    }
+
+    switch (profile)
+    {
+    case QuirkProfile::Cosmac:
+        run<QuirkProfile::Cosmac>(chip8, count);
+        break;
+    case QuirkProfile::SuperChip:
+        run<QuirkProfile::SuperChip>(chip8, count);
+        break;
+    case QuirkProfile::XoChip:
+        run<QuirkProfile::XoChip>(chip8, count);
+        break;
+    default:
+        run<QuirkProfile::Default>(chip8, count);
+        break;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "chip8.h"
+
+enum class FusedKind : uint8_t
+{
+    None,
+    // 1NNN to itself, the idle loop of a finished game
+    Spin,
+    // 7XNN 3XKK/4XKK 1NNN back to the 7XNN
+    CountedLoop,
+    // FX07 3XKK/4XKK 1NNN back to the FX07
+    DelayWait,
+};
+
+[[nodiscard]] const char* FusedKindName(FusedKind kind);
+
+// Instruction sequence run as one operation, with the opcodes it was recognised from
+struct FusedOp
+{
+    FusedKind kind = FusedKind::None;
+    // Instructions in the sequence
+    uint8_t length = 0;
+    uint8_t bytes[6]{};
+};
+
+// Superinstructions for the tight loops of a loaded program.
+//
+// Only loops are fused: straight-line sequences measured slower than the interpreter, the saved dispatches did not
+// pay for the check. Sequences are picked from the code AnalyzeProgram reaches. A sequence runs fused when pc is its
+// first instruction, its bytes in memory are still the ones it was built from and the whole sequence fits in the
+// remaining count. Spins and delay waits are solved from the count and the delay timer instead of iterated, counted
+// loops iterate without dispatching. Fused operations write registers, timers and pc exactly as the instructions one
+// by one would, so the state after Run is the same as after Chip8::Run with the same count and snapshots, the
+// debugger and the trace see no difference.
+class FusionTable
+{
+public:
+    FusionTable() = default;
+    // Analyses the program as profile runs it, Run must be called with the same profile
+    FusionTable(const Chip8& chip8, QuirkProfile profile);
+
+    void Run(Chip8& chip8, QuirkProfile profile, int count) const;
+
+    // Fused sequence starting at address, nullptr when there is none
+    [[nodiscard]] const FusedOp* At(uint16_t address) const;
+    [[nodiscard]] size_t Size() const { return size; }
+
+private:
+    template <QuirkProfile profile>
+    void run(Chip8& chip8, int count) const;
+
+    // Indexed by address, empty when nothing was fused
+    std::vector<FusedOp> ops;
+    // Instructions the interpreter can run from each address before it could reach a sequence, 0 at the start of one
+    std::vector<uint8_t> interpreted;
+    size_t size = 0;
+};
@@ -0,0 +1,579 @@
+#include "gdb_stub.h"
+
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#endif
+
+#if !defined(_WIN32)
+namespace
+{
+// V0..VF, I, PC, SP, DT, ST
+constexpr int registerCount = 21;
+constexpr int registerI = 16;
+constexpr int registerPc = 17;
+constexpr int registerSp = 18;
+constexpr int registerDelay = 19;
+constexpr int registerSound = 20;
+
+#if defined(MSG_NOSIGNAL)
+constexpr int sendFlags = MSG_NOSIGNAL;
+#else
+constexpr int sendFlags = 0;
+#endif
+
+constexpr const char* targetXml =
+    "<?xml version=\"1.0\"?>"
+    "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">"
+    "<target version=\"1.0\"><feature name=\"org.chip8.core\">"
+    "<reg name=\"v0\" bitsize=\"8\"/><reg name=\"v1\" bitsize=\"8\"/><reg name=\"v2\" bitsize=\"8\"/>"
+    "<reg name=\"v3\" bitsize=\"8\"/><reg name=\"v4\" bitsize=\"8\"/><reg name=\"v5\" bitsize=\"8\"/>"
+    "<reg name=\"v6\" bitsize=\"8\"/><reg name=\"v7\" bitsize=\"8\"/><reg name=\"v8\" bitsize=\"8\"/>"
+    "<reg name=\"v9\" bitsize=\"8\"/><reg name=\"va\" bitsize=\"8\"/><reg name=\"vb\" bitsize=\"8\"/>"
+    "<reg name=\"vc\" bitsize=\"8\"/><reg name=\"vd\" bitsize=\"8\"/><reg name=\"ve\" bitsize=\"8\"/>"
+    "<reg name=\"vf\" bitsize=\"8\"/><reg name=\"i\" bitsize=\"16\" type=\"data_ptr\"/>"
+    "<reg name=\"pc\" bitsize=\"16\" type=\"code_ptr\"/><reg name=\"sp\" bitsize=\"8\"/>"
+    "<reg name=\"dt\" bitsize=\"8\"/><reg name=\"st\" bitsize=\"8\"/>"
+    "</feature></target>";
+
+bool isHex(unsigned char c) { return std::isxdigit(c) != 0; }
+
+bool isDecimal(unsigned char c) { return std::isdigit(c) != 0; }
+
+bool setNonBlocking(int fd) { return fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == 0; }
+
+std::string registerHex(const Chip8& chip8, int index)
+{
+    switch (index)
+    {
+    case registerI:
+        return std::format("{:02x}{:02x}", chip8.ri & 0xff, chip8.ri >> 8);
+    case registerPc:
+        return std::format("{:02x}{:02x}", chip8.pc & 0xff, chip8.pc >> 8);
+    case registerSp:
+        return std::format("{:02x}", chip8.sp);
+    case registerDelay:
+        return std::format("{:02x}", chip8.rdelay);
+    case registerSound:
+        return std::format("{:02x}", chip8.rsound);
+    default:
+        return std::format("{:02x}", chip8.regs[index]);
+    }
+}
+
+// Little endian hex of the register's width, false when text is not exactly that
+bool setRegister(Chip8& chip8, int index, const std::string& text)
+{
+    const size_t width = index == registerI || index == registerPc ? 4 : 2;
+    if (text.size() != width || !std::all_of(text.begin(), text.end(), isHex))
+    {
+        return false;
+    }
+    auto value = static_cast<uint16_t>(std::strtoul(text.substr(0, 2).c_str(), nullptr, 16));
+    if (width == 4)
+    {
+        value |= static_cast<uint16_t>(std::strtoul(text.substr(2, 2).c_str(), nullptr, 16) << 8);
+    }
+
+    switch (index)
+    {
+    case registerI:
+        chip8.ri = value;
+        break;
+    case registerPc:
+        chip8.pc = value;
+        break;
+    case registerSp:
+        chip8.sp = static_cast<uint8_t>(std::min<int>(value, stackSize));
+        break;
+    case registerDelay:
+        chip8.rdelay = static_cast<uint8_t>(value);
+        break;
+    case registerSound:
+        chip8.rsound = static_cast<uint8_t>(value);
+        break;
+    default:
+        chip8.regs[index] = static_cast<uint8_t>(value);
+        break;
+    }
+    return true;
+}
+
+// "addr,length" in hex
+bool parseRange(const std::string& text, uint32_t& address, uint32_t& length)
+{
+    char* end = nullptr;
+    address = std::strtoul(text.c_str(), &end, 16);
+    if (*end != ',')
+    {
+        return false;
+    }
+    length = std::strtoul(end + 1, &end, 16);
+    return *end == '\0' || *end == ':' || *end == ',';
+}
+}  // namespace
+#endif
+
+GdbStub::~GdbStub()
+{
+#if !defined(_WIN32)
+    disconnect();
+    if (listener >= 0)
+    {
+        close(listener);
+    }
+    if (!unixPath.empty())
+    {
+        unlink(unixPath.c_str());
+    }
+#endif
+}
+
+bool GdbStub::Listen(const std::string& endpoint)
+{
+#if defined(_WIN32)
+    (void)endpoint;
+    return false;
+#else
+    const bool tcp = endpoint.starts_with("tcp:") ||
+                     (!endpoint.empty() && std::all_of(endpoint.begin(), endpoint.end(), isDecimal));
+    if (tcp)
+    {
+        const auto port = std::atoi(endpoint.c_str() + (endpoint.starts_with("tcp:") ? 4 : 0));
+        if (port <= 0 || port > 0xffff)
+        {
+            return false;
+        }
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        if (listener < 0)
+        {
+            return false;
+        }
+        const int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        const auto path = endpoint.starts_with("unix:") ? endpoint.substr(5) : endpoint;
+        sockaddr_un address{};
+        if (path.empty() || path.size() >= sizeof(address.sun_path))
+        {
+            return false;
+        }
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0)
+        {
+            return false;
+        }
+        // A socket left behind by an earlier run would make bind fail
+        unlink(path.c_str());
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size());
+        if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            return false;
+        }
+        unixPath = path;
+    }
+    return ::listen(listener, 1) == 0 && setNonBlocking(listener);
+#endif
+}
+
+int GdbStub::RunFrame(Chip8& chip8, QuirkProfile profile, int count)
+{
+#if defined(_WIN32)
+    chip8.Run(profile, count);
+    return count;
+#else
+    acceptClient();
+    if (client >= 0)
+    {
+        receive(chip8, profile);
+    }
+    if (Halted())
+    {
+        return 0;
+    }
+
+    const auto stop = debugger.Run(chip8, profile, count);
+    if (client >= 0 && (stop.reason == StopReason::Breakpoint || stop.reason == StopReason::Watchpoint))
+    {
+        halted = true;
+        reportStop(stop);
+    }
+    return stop.executed;
+#endif
+}
+
+#if !defined(_WIN32)
+void GdbStub::acceptClient()
+{
+    if (listener < 0 || client >= 0)
+    {
+        return;
+    }
+    client = ::accept(listener, nullptr, nullptr);
+    if (client < 0)
+    {
+        return;
+    }
+    setNonBlocking(client);
+    // GDB expects the target stopped when it attaches
+    halted = true;
+    noAck = false;
+    input.clear();
+    lastPacket.clear();
+}
+
+void GdbStub::receive(Chip8& chip8, QuirkProfile profile)
+{
+    char buffer[4096];
+    ssize_t length;
+    // A signal, like the frontend's SIGUSR1, interrupting the read is not a hang-up
+    while ((length = read(client, buffer, sizeof(buffer))) > 0 || (length < 0 && errno == EINTR))
+    {
+        if (length > 0)
+        {
+            input.append(buffer, length);
+        }
+    }
+    // Packets sent right before hanging up, like D, are still answered
+    const bool closed = length == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+
+    while (!input.empty() && client >= 0)
+    {
+        if (input[0] == '\x03')
+        {
+            input.erase(0, 1);
+            halted = true;
+            sendPacket("S02");
+        }
+        else if (input[0] == '-')
+        {
+            input.erase(0, 1);
+            sendRaw(lastPacket);
+        }
+        else if (input[0] != '$')
+        {
+            input.erase(0, 1);
+        }
+        else
+        {
+            const auto hash = input.find('#');
+            if (hash == std::string::npos || input.size() < hash + 3)
+            {
+                // The rest of the packet arrives next frame
+                break;
+            }
+            const auto payload = input.substr(1, hash - 1);
+            const auto checksum = std::strtoul(input.substr(hash + 1, 2).c_str(), nullptr, 16);
+            input.erase(0, hash + 3);
+
+            uint8_t sum = 0;
+            for (const auto c : payload)
+            {
+                sum += static_cast<uint8_t>(c);
+            }
+            if (!noAck)
+            {
+                sendRaw(sum == checksum ? "+" : "-");
+            }
+            if (sum == checksum || noAck)
+            {
+                handle(payload, chip8, profile);
+            }
+        }
+    }
+    if (closed)
+    {
+        disconnect();
+    }
+}
+
+void GdbStub::handle(const std::string& packet, Chip8& chip8, QuirkProfile profile)
+{
+    const auto command = packet.empty() ? '\0' : packet[0];
+    const auto arguments = packet.empty() ? std::string{} : packet.substr(1);
+    uint32_t address = 0;
+    uint32_t length = 0;
+    // Memory is the address space of the profile, 64 KiB only for xochip with high memory. Below that size the
+    // XO-CHIP view of a byte is every profile's view.
+    const auto memorySize = static_cast<uint32_t>(chip8.MemorySize(profile));
+
+    switch (command)
+    {
+    case '?':
+        sendPacket("S05");
+        break;
+    case 'g':
+    {
+        std::string registers;
+        for (int index = 0; index < registerCount; index++)
+        {
+            registers += registerHex(chip8, index);
+        }
+        sendPacket(registers);
+        break;
+    }
+    case 'G':
+    {
+        // Parse into a copy so a malformed packet changes nothing
+        auto updated = chip8;
+        size_t offset = 0;
+        bool valid = true;
+        for (int index = 0; index < registerCount && valid; index++)
+        {
+            const size_t width = index == registerI || index == registerPc ? 4 : 2;
+            valid = offset + width <= arguments.size() && setRegister(updated, index, arguments.substr(offset, width));
+            offset += width;
+        }
+        if (valid && offset == arguments.size())
+        {
+            chip8 = updated;
+        }
+        sendPacket(valid && offset == arguments.size() ? "OK" : "E01");
+        break;
+    }
+    case 'p':
+    {
+        const auto index = static_cast<int>(std::strtol(arguments.c_str(), nullptr, 16));
+        sendPacket(index >= 0 && index < registerCount ? registerHex(chip8, index) : "E01");
+        break;
+    }
+    case 'P':
+    {
+        const auto equals = arguments.find('=');
+        const auto index = static_cast<int>(std::strtol(arguments.c_str(), nullptr, 16));
+        const bool valid = equals != std::string::npos && index >= 0 && index < registerCount &&
+                           setRegister(chip8, index, arguments.substr(equals + 1));
+        sendPacket(valid ? "OK" : "E01");
+        break;
+    }
+    case 'm':
+        if (!parseRange(arguments, address, length) || address >= memorySize)
+        {
+            sendPacket("E01");
+        }
+        else
+        {
+            std::string bytes;
+            for (uint32_t i = address; i < std::min(address + length, memorySize); i++)
+            {
+                bytes += std::format("{:02x}", chip8.MemoryAt<QuirkProfile::XoChip>(i));
+            }
+            sendPacket(bytes);
+        }
+        break;
+    case 'M':
+    {
+        const auto colon = arguments.find(':');
+        const bool valid = parseRange(arguments, address, length) && colon != std::string::npos &&
+                           arguments.size() - colon - 1 == 2 * length && address + length <= memorySize;
+        if (valid)
+        {
+            for (uint32_t i = 0; i < length; i++)
+            {
+                chip8.MemoryAt<QuirkProfile::XoChip>(address + i) =
+                    static_cast<uint8_t>(std::strtoul(arguments.substr(colon + 1 + 2 * i, 2).c_str(), nullptr, 16));
+            }
+        }
+        sendPacket(valid ? "OK" : "E01");
+        break;
+    }
+    case 'Z':
+    case 'z':
+    {
+        // Z0/Z1 break on pc, Z2 on writes. Read and access watchpoints are left unsupported.
+        const auto type = arguments.empty() ? '\0' : arguments[0];
+        if ((type != '0' && type != '1' && type != '2') || arguments.size() < 2 ||
+            !parseRange(arguments.substr(2), address, length))
+        {
+            sendPacket("");
+            break;
+        }
+        // Past the memory the profile reaches nothing runs or changes, the point would never hit
+        if (command == 'Z' && address + (type == '2' ? std::max<uint32_t>(length, 1) : 1) > memorySize)
+        {
+            sendPacket("E01");
+            break;
+        }
+        for (uint32_t i = 0; i < (type == '2' ? std::max<uint32_t>(length, 1) : 1); i++)
+        {
+            const auto location = static_cast<uint16_t>(address + i);
+            if (type == '2' && command == 'Z')
+            {
+                debugger.WatchMemory(location);
+            }
+            else if (type == '2')
+            {
+                debugger.UnwatchMemory(location);
+            }
+            else if (command == 'Z')
+            {
+                debugger.SetBreakpoint(location);
+            }
+            else
+            {
+                debugger.ClearBreakpoint(location);
+            }
+        }
+        sendPacket("OK");
+        break;
+    }
+    case 'c':
+        if (!arguments.empty())
+        {
+            chip8.pc = static_cast<uint16_t>(std::strtoul(arguments.c_str(), nullptr, 16));
+        }
+        // Answered with a stop reply once a breakpoint or watchpoint hits
+        halted = false;
+        break;
+    case 's':
+        if (!arguments.empty())
+        {
+            chip8.pc = static_cast<uint16_t>(std::strtoul(arguments.c_str(), nullptr, 16));
+        }
+        reportStop(debugger.Step(chip8, profile));
+        break;
+    case 'H':
+        sendPacket("OK");
+        break;
+    case 'D':
+        sendPacket("OK");
+        disconnect();
+        break;
+    case 'k':
+        disconnect();
+        break;
+    case 'q':
+        if (packet.starts_with("qSupported"))
+        {
+            sendPacket("PacketSize=1000;qXfer:features:read+;QStartNoAckMode+");
+        }
+        else if (packet.starts_with("qXfer:features:read:target.xml:") &&
+                 parseRange(packet.substr(std::strlen("qXfer:features:read:target.xml:")), address, length))
+        {
+            const std::string xml = targetXml;
+            const auto part = address < xml.size() ? xml.substr(address, length) : std::string{};
+            sendPacket((address + length >= xml.size() ? "l" : "m") + part);
+        }
+        else if (packet == "qAttached")
+        {
+            sendPacket("1");
+        }
+        else if (packet == "qC")
+        {
+            sendPacket("QC1");
+        }
+        else if (packet == "qfThreadInfo")
+        {
+            sendPacket("m1");
+        }
+        else if (packet == "qsThreadInfo")
+        {
+            sendPacket("l");
+        }
+        else
+        {
+            sendPacket("");
+        }
+        break;
+    case 'Q':
+        if (packet == "QStartNoAckMode")
+        {
+            sendPacket("OK");
+            noAck = true;
+        }
+        else
+        {
+            sendPacket("");
+        }
+        break;
+    default:
+        // Unsupported packets get an empty reply, including vCont? and vMustReplyEmpty
+        sendPacket("");
+        break;
+    }
+}
+
+void GdbStub::reportStop(const DebugStop& stop)
+{
+    if (stop.reason == StopReason::Watchpoint && !stop.registerWatch)
+    {
+        sendPacket(std::format("T05watch:{:x};", stop.location));
+    }
+    else
+    {
+        sendPacket("S05");
+    }
+}
+
+void GdbStub::sendPacket(const std::string& payload)
+{
+    uint8_t sum = 0;
+    for (const auto c : payload)
+    {
+        sum += static_cast<uint8_t>(c);
+    }
+    lastPacket = std::format("${}#{:02x}", payload, sum);
+    sendRaw(lastPacket);
+}
+
+void GdbStub::sendRaw(const std::string& data)
+{
+    size_t offset = 0;
+    while (client >= 0 && offset < data.size())
+    {
+        const auto sent = ::send(client, data.data() + offset, data.size() - offset, sendFlags);
+        if (sent > 0)
+        {
+            offset += sent;
+        }
+        else if (errno == EINTR)
+        {
+            continue;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            pollfd writable{client, POLLOUT, 0};
+            poll(&writable, 1, 100);
+        }
+        else
+        {
+            disconnect();
+        }
+    }
+}
+
+void GdbStub::disconnect()
+{
+    if (client >= 0)
+    {
+        close(client);
+        client = -1;
+    }
+    // Breakpoints belong to the session, the machine runs freely again
+    debugger = Debugger{};
+    halted = false;
+}
+#endif
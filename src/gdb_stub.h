@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+
+#include "chip8.h"
+#include "debugger.h"
+
+// GDB remote serial protocol server for one machine.
+//
+// The frontend calls RunFrame once per frame instead of Chip8::Run. It polls the socket without blocking, answers
+// whatever GDB sent, then runs the frame through the Debugger. While GDB has no breakpoints or watchpoints set that is
+// the plain interpreter, so an attached debugger costs nothing per instruction until it stops the machine.
+//
+// Registers in 'g' order: V0..VF (8 bit), I (16 bit), PC (16 bit), SP, DT, ST (8 bit), little endian. The layout is
+// also served as target.xml. Memory is the address space of the quirk profile: 64 KiB for xochip with high memory,
+// 4 KiB otherwise. Z0/z0 set software breakpoints, Z2/z2 write watchpoints. Not available on Windows.
+class GdbStub
+{
+public:
+    GdbStub() = default;
+    ~GdbStub();
+
+    GdbStub(const GdbStub&) = delete;
+    GdbStub& operator=(const GdbStub&) = delete;
+
+    // "unix:<path>", "tcp:<port>" or a bare port number, anything else is a Unix socket path. TCP listens on localhost
+    // only.
+    [[nodiscard]] bool Listen(const std::string& endpoint);
+
+    // Serve GDB, then run count instructions unless it holds the machine stopped. Returns the instructions executed.
+    int RunFrame(Chip8& chip8, QuirkProfile profile, int count);
+
+    [[nodiscard]] bool Connected() const { return client >= 0; }
+    [[nodiscard]] bool Halted() const { return Connected() && halted; }
+
+private:
+    void acceptClient();
+    void receive(Chip8& chip8, QuirkProfile profile);
+    void handle(const std::string& packet, Chip8& chip8, QuirkProfile profile);
+    void sendPacket(const std::string& payload);
+    void sendRaw(const std::string& data);
+    void reportStop(const DebugStop& stop);
+    void disconnect();
+
+    int listener = -1;
+    int client = -1;
+    std::string unixPath;
+    std::string input;
+    // Resent when GDB answers '-'
+    std::string lastPacket;
+    bool halted = false;
+    bool noAck = false;
+    Debugger debugger;
+};
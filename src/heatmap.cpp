@@ -0,0 +1,99 @@
+#include "heatmap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <vector>
+
+void MemoryHeatmap::Run(Chip8& chip8, QuirkProfile profile, int count)
+{
+    auto run = [&]<QuirkProfile p>()
+    {
+        for (int i = 0; i < count; i++)
+        {
+            Step<p>(chip8);
+        }
+    };
+
+    switch (profile)
+    {
+    case QuirkProfile::Cosmac:
+        run.operator()<QuirkProfile::Cosmac>();
+        break;
+    case QuirkProfile::SuperChip:
+        run.operator()<QuirkProfile::SuperChip>();
+        break;
+    case QuirkProfile::XoChip:
+        run.operator()<QuirkProfile::XoChip>();
+        break;
+    default:
+        run.operator()<QuirkProfile::Default>();
+        break;
+    }
+}
+
+int MemoryHeatmap::SelfModifiedCount() const
+{
+    int count = 0;
+    for (int address = 0; address < 4096; address++)
+    {
+        count += writes[address] && executes[address];
+    }
+    return count;
+}
+
+void MemoryHeatmap::WriteCsv(std::ostream& out) const
+{
+    out << "address,reads,writes,executes\n";
+    for (int address = 0; address < 4096; address++)
+    {
+        if (reads[address] || writes[address] || executes[address])
+        {
+            out << std::format("0x{:03x},{},{},{}\n", address, reads[address], writes[address], executes[address]);
+        }
+    }
+}
+
+void MemoryHeatmap::WritePpm(std::ostream& out, int cellSize) const
+{
+    constexpr int columns = 64;
+    constexpr int rows = 4096 / columns;
+
+    // Log scale against the busiest address of each kind, anything touched at all is visible
+    auto scale = [](const std::array<uint64_t, 4096>& counts)
+    {
+        const auto peak = std::log1p(static_cast<double>(*std::max_element(counts.begin(), counts.end())));
+        return [&counts, peak](int address) -> uint8_t
+        {
+            if (counts[address] == 0)
+            {
+                return 0;
+            }
+            return static_cast<uint8_t>(64 + 191 * std::log1p(static_cast<double>(counts[address])) / peak);
+        };
+    };
+    const auto red = scale(writes);
+    const auto green = scale(reads);
+    const auto blue = scale(executes);
+
+    const int width = columns * cellSize;
+    out << std::format("P6\n{} {}\n255\n", width, rows * cellSize);
+
+    std::vector<uint8_t> line(width * 3);
+    for (int row = 0; row < rows; row++)
+    {
+        for (int column = 0; column < columns; column++)
+        {
+            const auto address = row * columns + column;
+            const uint8_t pixel[3] = {red(address), green(address), blue(address)};
+            for (int x = 0; x < cellSize; x++)
+            {
+                std::copy(pixel, pixel + 3, &line[(column * cellSize + x) * 3]);
+            }
+        }
+        for (int y = 0; y < cellSize; y++)
+        {
+            out.write(reinterpret_cast<const char*>(line.data()), static_cast<std::streamsize>(line.size()));
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <ostream>
+
+#include "chip8.h"
+
+// Counts reads, writes and instruction fetches per address of the 4 KiB memory.
+//
+// Like Profiler it wraps the step: the accesses are worked out from the instruction about to run, so machines
+// without a heatmap execute the plain interpreter. Reads come from DXYN sprite rows, FX65 and XO-CHIP's 5XY3 and
+// F002, writes from FX33, FX55 and 5XY2, executes from the bytes of every fetched instruction. Addresses wrap as the
+// profile wraps them. XO-CHIP accesses past 4 KiB are not counted.
+class MemoryHeatmap
+{
+public:
+    template <QuirkProfile profile = QuirkProfile::Default>
+    void Record(const Chip8& chip8)
+    {
+        constexpr auto quirks = QuirksOf(profile);
+        const auto memorySize = chip8.MemorySize(profile);
+        const auto opcode = chip8.NextOpcode(profile);
+        const auto x = (opcode >> 8) & 0xf;
+        const auto y = (opcode >> 4) & 0xf;
+
+        access(executes, chip8.pc, quirks.xoChip && opcode == 0xf000 ? 4 : 2, memorySize);
+
+        if ((opcode >> 12) == 0xd)
+        {
+            // Rows clipped at the bottom edge are never fetched, DXY0 is 16 rows of two bytes with SUPER-CHIP. XO-CHIP
+            // reads one sprite per selected plane.
+            const bool wide = quirks.schipDisplay && (opcode & 0xf) == 0;
+            const auto height = chip8.DisplayHeight();
+            const auto py = chip8.regs[(opcode >> 4) & 0xf] % height;
+            const auto n = wide ? 16 : opcode & 0xf;
+            const auto rows = quirks.spritesWrap ? n : std::min(n, height - py);
+            const auto planes = quirks.xoChip ? std::popcount(chip8.planeMask) : 1;
+            for (int plane = 0; plane < planes; plane++)
+            {
+                access(reads, chip8.ri + plane * (wide ? 32 : n), wide ? rows * 2 : rows, memorySize);
+            }
+        }
+        else if ((opcode & 0xf0ff) == 0xf033)
+        {
+            access(writes, chip8.ri, 3, memorySize);
+        }
+        else if ((opcode & 0xf0ff) == 0xf055)
+        {
+            access(writes, chip8.ri, x + 1, memorySize);
+        }
+        else if ((opcode & 0xf0ff) == 0xf065)
+        {
+            access(reads, chip8.ri, x + 1, memorySize);
+        }
+        else if (quirks.xoChip && (opcode & 0xf00e) == 0x5002)
+        {
+            // 5XY2/5XY3 move VX to VY in either direction, the range at I is the same
+            access((opcode & 1) ? reads : writes, chip8.ri, std::abs(y - x) + 1, memorySize);
+        }
+        else if (quirks.xoChip && opcode == 0xf002)
+        {
+            access(reads, chip8.ri, audioPatternSize, memorySize);
+        }
+    }
+
+    template <QuirkProfile profile = QuirkProfile::Default>
+    void Step(Chip8& chip8)
+    {
+        Record<profile>(chip8);
+        chip8.ExecuteNext<profile>();
+    }
+
+    // Instrumented counterpart of Chip8::Run
+    void Run(Chip8& chip8, QuirkProfile profile, int count);
+
+    [[nodiscard]] uint64_t Reads(uint16_t address) const { return reads[address & 0xfff]; }
+    [[nodiscard]] uint64_t Writes(uint16_t address) const { return writes[address & 0xfff]; }
+    [[nodiscard]] uint64_t Executes(uint16_t address) const { return executes[address & 0xfff]; }
+
+    // Addresses that were both written and executed, in either order: the ROM modifies its own code there
+    [[nodiscard]] int SelfModifiedCount() const;
+
+    // "address,reads,writes,executes" for every address touched at least once
+    void WriteCsv(std::ostream& out) const;
+
+    // Binary PPM, one cell per address in rows of 64 with red = writes, green = reads, blue = executes on a log
+    // scale. cellSize pixels per cell.
+    void WritePpm(std::ostream& out, int cellSize = 8) const;
+
+private:
+    // memorySize is the power of two the profile wraps addresses at
+    void access(std::array<uint64_t, 4096>& counts, unsigned start, int length, int memorySize)
+    {
+        for (int i = 0; i < length; i++)
+        {
+            const auto address = (start + i) & (memorySize - 1);
+            if (address < counts.size())
+            {
+                counts[address]++;
+            }
+        }
+    }
+
+    std::array<uint64_t, 4096> reads{};
+    std::array<uint64_t, 4096> writes{};
+    std::array<uint64_t, 4096> executes{};
+};
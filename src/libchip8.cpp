@@ -0,0 +1,167 @@
+#include "libchip8.h"
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+#include "chip8.h"
+
+static_assert(CHIP8_DISPLAY_WIDTH == chip8Width && CHIP8_DISPLAY_HEIGHT == chip8Height);
+
+namespace
+{
+// Leads every saved state. Bump stateVersion whenever the layout of Chip8 changes.
+struct StateHeader
+{
+    uint32_t version;
+    uint32_t size;
+};
+
+constexpr uint32_t stateVersion = 2;
+constexpr size_t stateSize = sizeof(StateHeader) + sizeof(Chip8);
+}  // namespace
+
+struct chip8_machine
+{
+    Chip8 chip8;
+    uint32_t seed;
+    uint16_t romSize;
+    uint8_t rom[maxRomSize];
+};
+
+uint32_t chip8_abi_version(void) { return CHIP8_ABI_VERSION; }
+
+chip8_machine* chip8_create(uint32_t seed)
+{
+    auto* machine = new (std::nothrow) chip8_machine{Chip8{seed}, seed, 0, {}};
+    return machine;
+}
+
+void chip8_destroy(chip8_machine* machine) { delete machine; }
+
+chip8_status chip8_load_rom(chip8_machine* machine, const uint8_t* data, size_t size)
+{
+    if (machine == nullptr || (data == nullptr && size > 0))
+    {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (size > maxRomSize)
+    {
+        return CHIP8_ERROR_ROM_TOO_LARGE;
+    }
+
+    std::memcpy(machine->rom, data, size);
+    machine->romSize = static_cast<uint16_t>(size);
+    chip8_reset(machine);
+    return CHIP8_OK;
+}
+
+void chip8_reset(chip8_machine* machine)
+{
+    if (machine == nullptr)
+    {
+        return;
+    }
+
+    machine->chip8 = Chip8{machine->seed};
+    machine->chip8.LoadRom({machine->rom, machine->romSize});
+}
+
+void chip8_run_cycles(chip8_machine* machine, uint32_t cycles)
+{
+    if (machine == nullptr)
+    {
+        return;
+    }
+
+    auto& chip8 = machine->chip8;
+    for (uint32_t i = 0; i < cycles; i++)
+    {
+        chip8.ExecuteNext();
+    }
+}
+
+void chip8_run_frames(chip8_machine* machine, uint32_t frames)
+{
+    if (machine == nullptr)
+    {
+        return;
+    }
+
+    // One frame at a time, frames * cyclesPerFrame would overflow
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        machine->chip8.Run(QuirkProfile::Default, cyclesPerFrame);
+    }
+}
+
+void chip8_set_keys(chip8_machine* machine, uint16_t keys)
+{
+    if (machine != nullptr)
+    {
+        machine->chip8.input = keys;
+    }
+}
+
+const uint64_t* chip8_framebuffer(const chip8_machine* machine)
+{
+    return machine != nullptr ? machine->chip8.display[0] : nullptr;
+}
+
+const uint8_t* chip8_memory(const chip8_machine* machine)
+{
+    return machine != nullptr ? machine->chip8.memory : nullptr;
+}
+
+uint8_t chip8_sound_active(const chip8_machine* machine) { return machine != nullptr && machine->chip8.rsound > 0; }
+
+size_t chip8_state_size(void) { return stateSize; }
+
+chip8_status chip8_save_state(const chip8_machine* machine, void* buffer, size_t size)
+{
+    if (machine == nullptr || buffer == nullptr)
+    {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (size < stateSize)
+    {
+        return CHIP8_ERROR_STATE_SIZE;
+    }
+
+    const StateHeader header{stateVersion, sizeof(Chip8)};
+    std::memcpy(buffer, &header, sizeof(header));
+    std::memcpy(static_cast<uint8_t*>(buffer) + sizeof(header), &machine->chip8, sizeof(Chip8));
+    return CHIP8_OK;
+}
+
+chip8_status chip8_load_state(chip8_machine* machine, const void* buffer, size_t size)
+{
+    if (machine == nullptr || buffer == nullptr)
+    {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (size != stateSize)
+    {
+        return CHIP8_ERROR_STATE_SIZE;
+    }
+
+    StateHeader header;
+    std::memcpy(&header, buffer, sizeof(header));
+    if (header.version != stateVersion || header.size != sizeof(Chip8))
+    {
+        return CHIP8_ERROR_STATE_VERSION;
+    }
+
+    const auto* state = static_cast<const uint8_t*>(buffer) + sizeof(header);
+    std::memcpy(&machine->chip8, state, sizeof(Chip8));
+    // Reading a bool that holds anything but 0 or 1 is undefined, rebuild it from the blob's byte
+    machine->chip8.hires = state[offsetof(Chip8, hires)] != 0;
+
+    // The library runs the Default profile: no high memory, never trust a pointer from a blob, and one plane
+    machine->chip8.highMemory = nullptr;
+    machine->chip8.planeMask = 1;
+    return CHIP8_OK;
+}
@@ -0,0 +1,77 @@
+/* Stable C interface to the interpreter core.
+ *
+ * All memory is allocated by chip8_create; no other call allocates. The ABI only
+ * grows: new functions may be added, existing signatures and enum values never change.
+ * Every call accepts a NULL machine and does nothing, returning CHIP8_ERROR_INVALID_ARGUMENT, NULL or 0. */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Windows programs linking the static library define CHIP8_STATIC, DLL users leave it undefined. */
+#if defined(_WIN32)
+#if defined(CHIP8_STATIC)
+#define CHIP8_API
+#elif defined(CHIP8_BUILDING_LIBRARY)
+#define CHIP8_API __declspec(dllexport)
+#else
+#define CHIP8_API __declspec(dllimport)
+#endif
+#else
+#define CHIP8_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHIP8_ABI_VERSION 3
+
+#define CHIP8_DISPLAY_WIDTH 64
+#define CHIP8_DISPLAY_HEIGHT 32
+
+typedef struct chip8_machine chip8_machine;
+
+typedef enum chip8_status
+{
+    CHIP8_OK = 0,
+    CHIP8_ERROR_INVALID_ARGUMENT = 1,
+    CHIP8_ERROR_ROM_TOO_LARGE = 2,
+    CHIP8_ERROR_STATE_SIZE = 3,
+    CHIP8_ERROR_STATE_VERSION = 4,
+} chip8_status;
+
+CHIP8_API uint32_t chip8_abi_version(void);
+
+/* Returns NULL if allocation fails. seed drives CXNN, 0 picks a fixed default. */
+CHIP8_API chip8_machine* chip8_create(uint32_t seed);
+CHIP8_API void chip8_destroy(chip8_machine* machine);
+
+/* Loads the image at 0x200 and keeps a copy for chip8_reset. At most 3584 bytes, the 4 KiB machine the library runs. */
+CHIP8_API chip8_status chip8_load_rom(chip8_machine* machine, const uint8_t* data, size_t size);
+
+/* Power-on state with the last loaded ROM. */
+CHIP8_API void chip8_reset(chip8_machine* machine);
+
+CHIP8_API void chip8_run_cycles(chip8_machine* machine, uint32_t cycles);
+CHIP8_API void chip8_run_frames(chip8_machine* machine, uint32_t frames);
+
+/* Bit N set = key N down. */
+CHIP8_API void chip8_set_keys(chip8_machine* machine, uint16_t keys);
+
+/* CHIP8_DISPLAY_HEIGHT rows, bit 63 of each row is the leftmost pixel.
+ * Points into the machine and stays valid until chip8_destroy. */
+CHIP8_API const uint64_t* chip8_framebuffer(const chip8_machine* machine);
+
+CHIP8_API const uint8_t* chip8_memory(const chip8_machine* machine);
+CHIP8_API uint8_t chip8_sound_active(const chip8_machine* machine);
+
+/* Snapshots are opaque byte blobs of chip8_state_size() bytes. They start with a format version and size, loading a
+ * blob written by another format fails with CHIP8_ERROR_STATE_VERSION. */
+CHIP8_API size_t chip8_state_size(void);
+CHIP8_API chip8_status chip8_save_state(const chip8_machine* machine, void* buffer, size_t size);
+CHIP8_API chip8_status chip8_load_state(chip8_machine* machine, const void* buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,482 @@
+#include "lockstep.h"
+
+#include <bit>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static_assert(lockstepLanes == 32, "Lanes assumes one 256-bit vector of byte lanes");
+
+namespace
+{
+// One uint8_t per machine. AVX2 uses a single register, SSE2 two, anything else plain loops.
+struct Lanes
+{
+#if defined(__AVX2__)
+    __m256i v;
+#elif defined(__SSE2__)
+    __m128i lo;
+    __m128i hi;
+#else
+    uint8_t v[lockstepLanes];
+#endif
+};
+
+#if defined(__AVX2__)
+
+Lanes load(const uint8_t* p) { return {_mm256_load_si256(reinterpret_cast<const __m256i*>(p))}; }
+void store(uint8_t* p, Lanes a) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), a.v); }
+Lanes splat(uint8_t value) { return {_mm256_set1_epi8(static_cast<char>(value))}; }
+Lanes add(Lanes a, Lanes b) { return {_mm256_add_epi8(a.v, b.v)}; }
+Lanes sub(Lanes a, Lanes b) { return {_mm256_sub_epi8(a.v, b.v)}; }
+Lanes addSaturate(Lanes a, Lanes b) { return {_mm256_adds_epu8(a.v, b.v)}; }
+Lanes max(Lanes a, Lanes b) { return {_mm256_max_epu8(a.v, b.v)}; }
+Lanes bitAnd(Lanes a, Lanes b) { return {_mm256_and_si256(a.v, b.v)}; }
+Lanes bitOr(Lanes a, Lanes b) { return {_mm256_or_si256(a.v, b.v)}; }
+Lanes bitXor(Lanes a, Lanes b) { return {_mm256_xor_si256(a.v, b.v)}; }
+Lanes andNot(Lanes a, Lanes b) { return {_mm256_andnot_si256(a.v, b.v)}; }
+Lanes equal(Lanes a, Lanes b) { return {_mm256_cmpeq_epi8(a.v, b.v)}; }
+Lanes shiftRight1(Lanes a) { return {_mm256_and_si256(_mm256_srli_epi16(a.v, 1), _mm256_set1_epi8(0x7f))}; }
+
+// Bit N set when pcs[N] == value
+uint32_t lanesAt(const uint16_t* pcs, uint16_t value)
+{
+    const auto* v = reinterpret_cast<const __m256i*>(pcs);
+    const auto wanted = _mm256_set1_epi16(static_cast<short>(value));
+    // packs interleaves the 128-bit halves, the permute puts the lanes back in order
+    const auto packed = _mm256_packs_epi16(_mm256_cmpeq_epi16(_mm256_load_si256(v), wanted),
+                                           _mm256_cmpeq_epi16(_mm256_load_si256(v + 1), wanted));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_permute4x64_epi64(packed, 0xd8)));
+}
+
+#elif defined(__SSE2__)
+
+Lanes load(const uint8_t* p)
+{
+    const auto* v = reinterpret_cast<const __m128i*>(p);
+    return {_mm_load_si128(v), _mm_load_si128(v + 1)};
+}
+void store(uint8_t* p, Lanes a)
+{
+    auto* v = reinterpret_cast<__m128i*>(p);
+    _mm_store_si128(v, a.lo);
+    _mm_store_si128(v + 1, a.hi);
+}
+Lanes splat(uint8_t value)
+{
+    return {_mm_set1_epi8(static_cast<char>(value)), _mm_set1_epi8(static_cast<char>(value))};
+}
+Lanes add(Lanes a, Lanes b) { return {_mm_add_epi8(a.lo, b.lo), _mm_add_epi8(a.hi, b.hi)}; }
+Lanes sub(Lanes a, Lanes b) { return {_mm_sub_epi8(a.lo, b.lo), _mm_sub_epi8(a.hi, b.hi)}; }
+Lanes addSaturate(Lanes a, Lanes b) { return {_mm_adds_epu8(a.lo, b.lo), _mm_adds_epu8(a.hi, b.hi)}; }
+Lanes max(Lanes a, Lanes b) { return {_mm_max_epu8(a.lo, b.lo), _mm_max_epu8(a.hi, b.hi)}; }
+Lanes bitAnd(Lanes a, Lanes b) { return {_mm_and_si128(a.lo, b.lo), _mm_and_si128(a.hi, b.hi)}; }
+Lanes bitOr(Lanes a, Lanes b) { return {_mm_or_si128(a.lo, b.lo), _mm_or_si128(a.hi, b.hi)}; }
+Lanes bitXor(Lanes a, Lanes b) { return {_mm_xor_si128(a.lo, b.lo), _mm_xor_si128(a.hi, b.hi)}; }
+Lanes andNot(Lanes a, Lanes b) { return {_mm_andnot_si128(a.lo, b.lo), _mm_andnot_si128(a.hi, b.hi)}; }
+Lanes equal(Lanes a, Lanes b) { return {_mm_cmpeq_epi8(a.lo, b.lo), _mm_cmpeq_epi8(a.hi, b.hi)}; }
+Lanes shiftRight1(Lanes a)
+{
+    const auto mask = _mm_set1_epi8(0x7f);
+    return {_mm_and_si128(_mm_srli_epi16(a.lo, 1), mask), _mm_and_si128(_mm_srli_epi16(a.hi, 1), mask)};
+}
+
+// Bit N set when pcs[N] == value
+uint32_t lanesAt(const uint16_t* pcs, uint16_t value)
+{
+    const auto* v = reinterpret_cast<const __m128i*>(pcs);
+    const auto wanted = _mm_set1_epi16(static_cast<short>(value));
+    const auto low = _mm_packs_epi16(_mm_cmpeq_epi16(_mm_load_si128(v), wanted),
+                                     _mm_cmpeq_epi16(_mm_load_si128(v + 1), wanted));
+    const auto high = _mm_packs_epi16(_mm_cmpeq_epi16(_mm_load_si128(v + 2), wanted),
+                                      _mm_cmpeq_epi16(_mm_load_si128(v + 3), wanted));
+    return static_cast<uint32_t>(_mm_movemask_epi8(low)) | static_cast<uint32_t>(_mm_movemask_epi8(high)) << 16;
+}
+
+#else
+
+template <typename Op>
+Lanes map(Lanes a, Lanes b, Op op)
+{
+    Lanes r;
+    for (int l = 0; l < lockstepLanes; l++)
+    {
+        r.v[l] = static_cast<uint8_t>(op(a.v[l], b.v[l]));
+    }
+    return r;
+}
+
+Lanes load(const uint8_t* p)
+{
+    Lanes r;
+    std::memcpy(r.v, p, sizeof(r.v));
+    return r;
+}
+void store(uint8_t* p, Lanes a) { std::memcpy(p, a.v, sizeof(a.v)); }
+Lanes splat(uint8_t value)
+{
+    Lanes r;
+    std::memset(r.v, value, sizeof(r.v));
+    return r;
+}
+Lanes add(Lanes a, Lanes b) { return map(a, b, [](int x, int y) { return x + y; }); }
+Lanes sub(Lanes a, Lanes b) { return map(a, b, [](int x, int y) { return x - y; }); }
+Lanes addSaturate(Lanes a, Lanes b) { return map(a, b, [](int x, int y) { return x + y > 0xff ? 0xff : x + y; }); }
+Lanes max(Lanes a, Lanes b) { return map(a, b, [](int x, int y) { return x > y ? x : y; }); }
+Lanes bitAnd(Lanes a, Lanes b) { return map(a, b, [](int x, int y) { return x & y; }); }
+Lanes bitOr(Lanes a, Lanes b) { return map(a, b, [](int x, int y) { return x | y; }); }
+Lanes bitXor(Lanes a, Lanes b) { return map(a, b, [](int x, int y) { return x ^ y; }); }
+Lanes andNot(Lanes a, Lanes b) { return map(a, b, [](int x, int y) { return ~x & y; }); }
+Lanes equal(Lanes a, Lanes b) { return map(a, b, [](int x, int y) { return x == y ? 0xff : 0; }); }
+Lanes shiftRight1(Lanes a) { return map(a, a, [](int x, int) { return x >> 1; }); }
+
+// Bit N set when pcs[N] == value
+uint32_t lanesAt(const uint16_t* pcs, uint16_t value)
+{
+    uint32_t lanes = 0;
+    for (int l = 0; l < lockstepLanes; l++)
+    {
+        lanes |= static_cast<uint32_t>(pcs[l] == value) << l;
+    }
+    return lanes;
+}
+
+#endif
+
+// Lanes selected by mask take a, the others keep b
+Lanes select(Lanes mask, Lanes a, Lanes b) { return bitOr(bitAnd(mask, a), andNot(mask, b)); }
+
+// a >= b per lane, as 0xff / 0x00
+Lanes greaterEqual(Lanes a, Lanes b) { return equal(max(a, b), a); }
+
+}  // namespace
+
+LockstepChip8::LockstepChip8(QuirkProfile profile) : profile(profile), quirks(QuirksOf(profile))
+{
+    if (!quirks.xoChip)
+    {
+        return;
+    }
+    highMemory.resize(static_cast<size_t>(lockstepLanes) * highMemorySize);
+    for (int lane = 0; lane < lockstepLanes; lane++)
+    {
+        lanes[lane].highMemory = &highMemory[static_cast<size_t>(lane) * highMemorySize];
+    }
+}
+
+void LockstepChip8::Store(int lane, const Chip8& chip8)
+{
+    auto& machine = lanes[lane];
+    auto* const laneHighMemory = machine.highMemory;
+    machine = chip8;
+    machine.highMemory = laneHighMemory;
+    if (laneHighMemory)
+    {
+        if (chip8.highMemory)
+        {
+            std::memcpy(laneHighMemory, chip8.highMemory, highMemorySize);
+        }
+        else
+        {
+            std::memset(laneHighMemory, 0, highMemorySize);
+        }
+    }
+
+    pc[lane] = chip8.pc;
+    scalar |= 1u << lane;
+}
+
+Chip8 LockstepChip8::Load(int lane) const
+{
+    Chip8 chip8 = lanes[lane];
+    if (!((scalar >> lane) & 1))
+    {
+        for (int r = 0; r < 16; r++)
+        {
+            chip8.regs[r] = regs[r][lane];
+        }
+        chip8.pc = pc[lane];
+        chip8.ri = ri[lane];
+        chip8.rdelay = rdelay[lane];
+        chip8.rsound = rsound[lane];
+    }
+    return chip8;
+}
+
+void LockstepChip8::ExecuteNext()
+{
+    uint32_t remaining = 0xffffffff;
+
+    while (remaining)
+    {
+        // Lanes on the same pc with the same opcode form one group
+        const auto lead = std::countr_zero(remaining);
+        const auto leadPc = pc[lead];
+        lanes[lead].pc = leadPc;
+        const auto opcode = lanes[lead].NextOpcode(profile);
+
+        auto group = lanesAt(pc, leadPc) & remaining;
+        for (auto others = group & (group - 1); others; others &= others - 1)
+        {
+            // Same pc, but self-modifying code may have changed the lane's opcode
+            const auto lane = std::countr_zero(others);
+            lanes[lane].pc = leadPc;
+            if (lanes[lane].NextOpcode(profile) != opcode)
+            {
+                group &= ~(1u << lane);
+            }
+        }
+        remaining &= ~group;
+
+        if (std::has_single_bit(group))
+        {
+            executeLane(lead);
+        }
+        else
+        {
+            executeGroup(opcode, group);
+        }
+    }
+
+    // The interpreter ticked the scalar lanes' timers itself
+    for (int lane = 0; lane < lockstepLanes; lane++)
+    {
+        const auto tick = !((scalar >> lane) & 1);
+        rdelay[lane] -= tick && rdelay[lane] != 0;
+        rsound[lane] -= tick && rsound[lane] != 0;
+    }
+}
+
+void LockstepChip8::executeGroup(uint16_t opcode, uint32_t group)
+{
+    const auto prefix = opcode >> 12;
+    // XO-CHIP skips step over F000 NNNN as a whole and 5XY2/5XY3 move memory, the interpreter works out both
+    const auto skips = prefix == 3 || prefix == 4 || prefix == 5 || prefix == 9;
+    const auto vector = prefix == 1 || (prefix >= 3 && prefix <= 0xa && !(quirks.xoChip && skips));
+    if (!vector)
+    {
+        // Everything else touches per-lane memory, stack or display
+        for (auto lanes = group; lanes; lanes &= lanes - 1)
+        {
+            executeLane(std::countr_zero(lanes));
+        }
+        return;
+    }
+    for (auto lanes = group & scalar; lanes; lanes &= lanes - 1)
+    {
+        toVector(std::countr_zero(lanes));
+    }
+
+    alignas(32) uint8_t activeBytes[lockstepLanes];
+    for (int lane = 0; lane < lockstepLanes; lane++)
+    {
+        activeBytes[lane] = (group >> lane) & 1 ? 0xff : 0;
+    }
+
+    const auto active = load(activeBytes);
+    const auto x = (opcode & 0x0f00) >> 8;
+    const auto y = (opcode & 0x00f0) >> 4;
+    const uint8_t lo = opcode & 0xff;
+    const auto one = splat(1);
+
+    alignas(32) uint8_t skip[lockstepLanes];
+    auto advance = [&](Lanes skipMask)
+    {
+        store(skip, skipMask);
+        for (int lane = 0; lane < lockstepLanes; lane++)
+        {
+            pc[lane] += activeBytes[lane] & (2 + (skip[lane] & 2));
+        }
+    };
+
+    switch (prefix)
+    {
+    // JUMP NNN
+    case 1:
+    {
+        for (int lane = 0; lane < lockstepLanes; lane++)
+        {
+            pc[lane] = activeBytes[lane] ? (opcode & 0x0fff) : pc[lane];
+        }
+        return;
+    }
+    // 3XNN
+    case 3:
+    {
+        advance(equal(load(regs[x]), splat(lo)));
+        return;
+    }
+    // 4XNN
+    case 4:
+    {
+        advance(andNot(equal(load(regs[x]), splat(lo)), splat(0xff)));
+        return;
+    }
+    // 5XY0
+    case 5:
+    {
+        advance(equal(load(regs[x]), load(regs[y])));
+        return;
+    }
+    // 6XNN
+    case 6:
+    {
+        store(regs[x], select(active, splat(lo), load(regs[x])));
+        advance(splat(0));
+        return;
+    }
+    // 7XNN
+    case 7:
+    {
+        const auto vx = load(regs[x]);
+        store(regs[x], select(active, add(vx, splat(lo)), vx));
+        advance(splat(0));
+        return;
+    }
+    case 8:
+    {
+        // Registers are reloaded after every store: x, y and 15 may alias, as in Chip8::ExecuteNext
+        auto setReg = [&](int r, Lanes value) { store(regs[r], select(active, value, load(regs[r]))); };
+        const auto shifted = quirks.shiftReadsVy ? y : x;
+
+        switch (opcode & 0xf)
+        {
+        // 8XY0
+        case 0:
+        {
+            setReg(x, load(regs[y]));
+            break;
+        }
+        // 8XY1
+        case 1:
+        {
+            setReg(x, bitOr(load(regs[x]), load(regs[y])));
+            if (quirks.logicClearsVf)
+            {
+                setReg(15, splat(0));
+            }
+            break;
+        }
+        // 8XY2
+        case 2:
+        {
+            setReg(x, bitAnd(load(regs[x]), load(regs[y])));
+            if (quirks.logicClearsVf)
+            {
+                setReg(15, splat(0));
+            }
+            break;
+        }
+        // 8XY3
+        case 3:
+        {
+            setReg(x, bitXor(load(regs[x]), load(regs[y])));
+            if (quirks.logicClearsVf)
+            {
+                setReg(15, splat(0));
+            }
+            break;
+        }
+        // 8XY4
+        case 4:
+        {
+            const auto vx = load(regs[x]);
+            const auto vy = load(regs[y]);
+            const auto sum = add(vx, vy);
+            // Saturating add only differs from the wrapping one on carry
+            const auto carry = andNot(equal(addSaturate(vx, vy), sum), one);
+            setReg(x, sum);
+            setReg(15, carry);
+            break;
+        }
+        // 8XY5
+        case 5:
+        {
+            setReg(15, bitAnd(greaterEqual(load(regs[x]), load(regs[y])), one));
+            setReg(x, sub(load(regs[x]), load(regs[y])));
+            break;
+        }
+        // 8XY6
+        case 6:
+        {
+            const auto value = load(regs[shifted]);
+            setReg(x, shiftRight1(value));
+            // As in the interpreter VY is read again after VX is written, they may be the same register
+            setReg(15, bitAnd(quirks.shiftReadsVy ? load(regs[y]) : value, one));
+            break;
+        }
+        // 8XY7
+        case 7:
+        {
+            setReg(x, sub(load(regs[y]), load(regs[x])));
+            const auto vx = load(regs[x]);
+            setReg(15, andNot(greaterEqual(vx, load(regs[y])), one));
+            break;
+        }
+        // 8XYE
+        case 0xe:
+        {
+            const auto value = load(regs[shifted]);
+            setReg(x, add(value, value));
+            setReg(15, bitAnd(greaterEqual(quirks.shiftReadsVy ? load(regs[y]) : value, splat(0x80)), one));
+            break;
+        }
+        }
+
+        advance(splat(0));
+        return;
+    }
+    // 9XY0
+    case 9:
+    {
+        advance(andNot(equal(load(regs[x]), load(regs[y])), splat(0xff)));
+        return;
+    }
+    // ANNN
+    case 0xa:
+    {
+        for (int lane = 0; lane < lockstepLanes; lane++)
+        {
+            ri[lane] = activeBytes[lane] ? (opcode & 0x0fff) : ri[lane];
+        }
+        advance(splat(0));
+        return;
+    }
+    }
+}
+
+void LockstepChip8::toVector(int lane)
+{
+    const auto& chip8 = lanes[lane];
+    for (int r = 0; r < 16; r++)
+    {
+        regs[r][lane] = chip8.regs[r];
+    }
+    ri[lane] = chip8.ri;
+    rdelay[lane] = chip8.rdelay;
+    rsound[lane] = chip8.rsound;
+    scalar &= ~(1u << lane);
+}
+
+void LockstepChip8::executeLane(int lane)
+{
+    auto& chip8 = lanes[lane];
+    if (!((scalar >> lane) & 1))
+    {
+        for (int r = 0; r < 16; r++)
+        {
+            chip8.regs[r] = regs[r][lane];
+        }
+        chip8.ri = ri[lane];
+        chip8.rdelay = rdelay[lane];
+        chip8.rsound = rsound[lane];
+        scalar |= 1u << lane;
+    }
+    chip8.pc = pc[lane];
+    chip8.Run(profile, 1);
+    pc[lane] = chip8.pc;
+}
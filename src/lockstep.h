@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "chip8.h"
+
+// Number of machines stepped together, one byte lane of a 256-bit vector each
+constexpr int lockstepLanes = 32;
+
+// Experimental engine running lockstepLanes machines, with the registers, pc, I and timers in structure-of-arrays
+// form.
+//
+// Every ExecuteNext runs one instruction on every lane. Lanes sitting on the same pc and opcode (the common case
+// when one ROM runs with different inputs or seeds) form a group; register and skip instructions of a group run
+// as SIMD operations under a lane mask. Everything else, and every lane that diverged from the others, steps its own
+// Chip8 with the interpreter of the profile, so results are identical to Chip8::Run on each machine under the
+// profile.
+struct LockstepChip8
+{
+    explicit LockstepChip8(QuirkProfile profile = QuirkProfile::Default);
+    // Lanes point into highMemory
+    LockstepChip8(const LockstepChip8&) = delete;
+    LockstepChip8& operator=(const LockstepChip8&) = delete;
+
+    // Copies memory past 4 KiB too when the profile is xochip and chip8 has it
+    void Store(int lane, const Chip8& chip8);
+    // Under xochip the machine's high memory is the lane's, valid while the engine lives
+    [[nodiscard]] Chip8 Load(int lane) const;
+
+    void ExecuteNext();
+
+private:
+    void executeGroup(uint16_t opcode, uint32_t group);
+    void executeLane(int lane);
+    // Moves a scalar lane's registers, I and timers into the vectors
+    void toVector(int lane);
+
+    // Vector state, current for the lanes not in scalar. pc is current for every lane.
+    alignas(32) uint8_t regs[16][lockstepLanes]{};
+    alignas(32) uint16_t pc[lockstepLanes]{};
+    alignas(32) uint16_t ri[lockstepLanes]{};
+    alignas(32) uint8_t rdelay[lockstepLanes]{};
+    alignas(32) uint8_t rsound[lockstepLanes]{};
+
+    // Each lane's machine, memory, stack, display and input always, the rest too while the lane is in scalar
+    Chip8 lanes[lockstepLanes];
+    // Lanes last stepped by the interpreter. They stay on lanes[] until a group runs as a vector again, so divergent
+    // lanes do not copy their registers back and forth on every instruction.
+    uint32_t scalar = 0;
+
+    QuirkProfile profile;
+    Quirks quirks;
+    // XO-CHIP memory past 4 KiB, highMemorySize per lane, empty for the other profiles
+    std::vector<uint8_t> highMemory;
+};
@@ -1,11 +1,34 @@
+#include <algorithm>
 #include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <format>
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <string>
 #include <thread>
 
+#include "analysis.h"
 #include "chip8.h"
+#include "file_watch.h"
+#include "fusion.h"
+#include "gdb_stub.h"
+#include "input.h"
+#include "metrics.h"
 #include "platform.h"
+#include "profiler.h"
+#include "recompiled.h"
+#include "rom.h"
+#include "romdb.h"
+#include "trace.h"
 
-constexpr auto execPerTick = 10;
+namespace
+{
+volatile std::sig_atomic_t traceRequested = 0;
+
+void requestTrace(int) { traceRequested = 1; }
+}  // namespace
 
 int main(int argc, char* argv[])
 {
@@ -15,41 +38,294 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    Chip8 chip8;
-    if (!chip8.LoadRom(argv[1]))
+    // Built next to the executable from rom/romdb.txt
+    auto indexPath = (std::filesystem::path{argv[0]}.parent_path() / "romdb.idx").string();
+    std::optional<QuirkProfile> quirksOverride;
+    bool watch = false;
+    std::optional<std::string> profilePath;
+    std::string tracePath = "chip8.trace";
+    std::optional<std::string> statsPath;
+    bool overlay = false;
+    std::optional<std::string> gdbEndpoint;
+    bool useRecompiled = false;
+    bool fuse = false;
+    for (int i = 2; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        QuirkProfile quirks;
+        if (arg == "--quirks" && i + 1 < argc && ParseQuirkProfile(argv[i + 1], quirks))
+        {
+            quirksOverride = quirks;
+            i++;
+            continue;
+        }
+        if (arg == "--romdb" && i + 1 < argc)
+        {
+            indexPath = argv[++i];
+            continue;
+        }
+        if (arg == "--profile" && i + 1 < argc)
+        {
+            profilePath = argv[++i];
+            continue;
+        }
+        if (arg == "--trace" && i + 1 < argc)
+        {
+            tracePath = argv[++i];
+            continue;
+        }
+        if (arg == "--stats" && i + 1 < argc)
+        {
+            statsPath = argv[++i];
+            continue;
+        }
+        if (arg == "--gdb" && i + 1 < argc)
+        {
+            gdbEndpoint = argv[++i];
+            continue;
+        }
+        if (arg == "--recompiled")
+        {
+            useRecompiled = true;
+            continue;
+        }
+        if (arg == "--fuse")
+        {
+            fuse = true;
+            continue;
+        }
+        if (arg == "--overlay")
+        {
+            overlay = true;
+            continue;
+        }
+        if (arg == "--watch")
+        {
+            watch = true;
+            continue;
+        }
+        std::cout << std::format("Unknown argument: {}\n", arg);
+        return 1;
+    }
+
+    // Read with the largest limit, the profile that decides the real one may come from the rom database
+    RomImage rom;
+    if (const auto error = ReadRomFile(argv[1], rom, QuirkProfile::XoChip); error != RomError::None)
+    {
+        std::cout << std::format("Failed to load rom {}: {}\n", argv[1], RomErrorMessage(error));
+        return 1;
+    }
+
+    // Unknown ROMs and a missing index keep the defaults
+    RomDbEntry settings;
+    RomIndex romIndex;
+    if (romIndex.Open(indexPath) && romIndex.Find(rom.sha1, settings))
     {
+        std::cout << std::format("Rom database: {} profile, {} Hz\n", QuirkProfileName(settings.quirks), settings.hz);
+    }
+    const auto quirks = quirksOverride.value_or(settings.quirks);
+
+    // High memory is only reached with the xochip profile
+    XoChip8 machine;
+    auto& chip8 = machine.chip8;
+    if (const auto error = chip8.LoadRom(rom.Bytes(), quirks); error != RomError::None)
+    {
+        std::cout << std::format("Failed to load rom {}: {}\n", argv[1], RomErrorMessage(error));
         return 1;
     }
 
+    // Report unknown opcodes and dynamic jumps now instead of when the interpreter reaches them
+    for (const auto& issue : AnalyzeProgram(chip8, quirks).issues)
+    {
+        std::cout << std::format("Warning at 0x{:03x}: {} ({:04x})\n", issue.address, issue.message, issue.opcode);
+    }
+    const auto execPerTick = std::max(1, settings.hz / 60);
+
     if (!platform_create_window("Chip8", 800, 600))
     {
         return 1;
     }
 
+    // Reload the ROM whenever it is rebuilt, the window and the ROM settings stay as they are
+    FileWatcher watcher;
+    if (watch && !watcher.Watch(argv[1]))
+    {
+        std::cout << std::format("Cannot watch {}\n", argv[1]);
+        watch = false;
+    }
+
+    // Collapsed stacks are written when the window is closed
+    std::optional<Profiler> profiler;
+    if (profilePath)
+    {
+        profiler.emplace();
+    }
+
+    // GDB is served at frame boundaries only, a frame runs through the plain interpreter until it sets a breakpoint
+    std::optional<GdbStub> gdb;
+    if (gdbEndpoint)
+    {
+        gdb.emplace();
+        if (!gdb->Listen(*gdbEndpoint))
+        {
+            std::cout << std::format("Cannot listen for gdb on {}\n", *gdbEndpoint);
+            return 1;
+        }
+        std::cout << std::format("Waiting for gdb on {}\n", *gdbEndpoint);
+    }
+
+    // A translation linked in for this ROM and profile runs instead of the interpreter when asked for
+    const auto findRecompiled = [&] { return useRecompiled ? FindRecompiled(rom.sha1, quirks) : nullptr; };
+    auto* recompiled = findRecompiled();
+    if (useRecompiled && !recompiled)
+    {
+        std::cout << "No recompiled translation of this rom, using the interpreter\n";
+    }
+
+    // Superinstructions are recognised once per load, a rewritten sequence falls back to the interpreter by itself
+    FusionTable fusion;
+    if (fuse)
+    {
+        fusion = FusionTable{chip8, quirks};
+        std::cout << std::format("Fused {} instruction sequences\n", fusion.Size());
+    }
+
+    // Always on unless profiling, debugging, running a translation or fusing. The last instructions are dumped when a
+    // fault is seen at a frame boundary or when SIGUSR1 arrives.
+    TraceRing trace;
+    bool faulted = false;
+#if defined(SIGUSR1)
+    std::signal(SIGUSR1, requestTrace);
+#endif
+
+    uint32_t videoBuffer[hiresWidth * hiresHeight]{};
+
     const auto fps = 60;
-    const auto frameDelay = 1000 / fps;
+    const auto frameDelay = std::chrono::microseconds{1000000 / fps};
+
+    // One JSON line per second to --stats, the same numbers on screen with --overlay
+    Metrics metrics{frameDelay};
+    std::ofstream statsFile;
+    if (statsPath)
+    {
+        statsFile.open(*statsPath, std::ios::app);
+    }
 
     while (true)
     {
-        auto frameStart = std::chrono::high_resolution_clock::now();
+        const auto frameStart = Metrics::Clock::now();
 
-        for (int i = 0; i < execPerTick; i++)
+        if (watch && watcher.Changed())
         {
-            chip8.ExecuteNext();
+            if (const auto error = ReadRomFile(argv[1], rom, quirks); error != RomError::None)
+            {
+                std::cout << std::format("Reload failed, keeping the running rom: {}\n", RomErrorMessage(error));
+            }
+            else
+            {
+                machine = XoChip8{};
+                chip8.LoadRom(rom.Bytes(), quirks);
+                faulted = false;
+                recompiled = findRecompiled();
+                if (fuse)
+                {
+                    fusion = FusionTable{chip8, quirks};
+                }
+                std::cout << std::format("Reloaded {}\n", argv[1]);
+            }
         }
 
-        if (!platform_update_window(chip8.videoBuffer))
+        for (int key = 0; key < KEY_CODE_COUNT; key++)
+        {
+            chip8.SetKey(key, IsKeyPressed(settings.keymap[key]));
+        }
+
+        const auto ticksBefore = chip8.timerTicks;
+        auto executed = execPerTick;
+        if (profiler)
+        {
+            profiler->Run(chip8, quirks, execPerTick);
+        }
+        else if (gdb)
+        {
+            executed = gdb->RunFrame(chip8, quirks, execPerTick);
+        }
+        else if (recompiled)
+        {
+            recompiled->run(chip8, execPerTick);
+        }
+        else if (fuse)
+        {
+            fusion.Run(chip8, quirks, execPerTick);
+        }
+        else
+        {
+            trace.Run(chip8, quirks, execPerTick);
+        }
+
+        const auto* fault = PendingFault(chip8, quirks);
+        if ((fault && !faulted) || traceRequested)
+        {
+            traceRequested = 0;
+            if (fault)
+            {
+                std::cout << std::format("Fault at pc 0x{:03x}: {}\n", chip8.pc, fault);
+            }
+            // The other run modes step the machine themselves and leave the ring empty
+            const char* untraced = profiler     ? "--profile"
+                                   : gdb        ? "--gdb"
+                                   : recompiled ? "--recompiled"
+                                   : fuse       ? "--fuse"
+                                                : nullptr;
+            if (untraced)
+            {
+                std::cout << std::format("No instruction trace is recorded with {}\n", untraced);
+            }
+            else if (const auto snapshot = trace.Snapshot(); WriteTrace(tracePath, snapshot))
+            {
+                std::cout << std::format("Last {} instructions written to {}\n", snapshot.records.size(), tracePath);
+            }
+        }
+        faulted = fault != nullptr;
+
+        const auto emulateEnd = Metrics::Clock::now();
+        const uint32_t timerTicks = chip8.timerTicks - ticksBefore;
+
+        chip8.RenderVideo(videoBuffer);
+        const bool presented = platform_update_window(videoBuffer, chip8.DisplayWidth(), chip8.DisplayHeight());
+        if (!presented)
         {
             platform_close_window();
+            if (profiler)
+            {
+                std::ofstream out(*profilePath);
+                profiler->WriteCollapsed(out);
+                std::cout << std::format("Profile of {} instructions written to {}\n", profiler->Samples(),
+                                         *profilePath);
+            }
             return 0;
         }
 
-        std::chrono::duration<float, std::milli> frameDuration = std::chrono::high_resolution_clock::now() - frameStart;
-        auto frameTime = frameDuration.count();
+        const auto presentEnd = Metrics::Clock::now();
+
+        if (const auto frameTime = presentEnd - frameStart; frameTime < frameDelay)
+        {
+            std::this_thread::sleep_for(frameDelay - frameTime);
+        }
+        const auto frameEnd = Metrics::Clock::now();
 
-        if (frameDelay > frameTime)
+        metrics.AddFrame({static_cast<uint64_t>(executed), static_cast<uint64_t>(timerTicks),
+                          emulateEnd - frameStart, presentEnd - emulateEnd, frameEnd - presentEnd});
+        if (metrics.Roll(frameEnd))
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(frameDelay - frameTime)));
+            if (statsFile.is_open())
+            {
+                statsFile << FormatMetricsJson(metrics.LastWindow()) << std::endl;
+            }
+            if (overlay)
+            {
+                platform_set_overlay(FormatMetricsOverlay(metrics.LastWindow()));
+            }
         }
     }
 }
@@ -0,0 +1,80 @@
+#include "metrics.h"
+
+#include <format>
+
+namespace
+{
+double toSeconds(std::chrono::nanoseconds duration) { return std::chrono::duration<double>(duration).count(); }
+
+constexpr double timerHz = 60;
+}  // namespace
+
+double MetricsWindow::InstructionsPerSecond() const
+{
+    return seconds > 0 ? static_cast<double>(instructions) / seconds : 0;
+}
+
+double MetricsWindow::FramesPerSecond() const
+{
+    return seconds > 0 ? static_cast<double>(framesEmulated) / seconds : 0;
+}
+
+Metrics::Metrics(std::chrono::nanoseconds frameBudget, Clock::time_point start)
+    : frameBudget(frameBudget), start(start), windowStart(start)
+{
+}
+
+void Metrics::AddFrame(const FrameSample& frame)
+{
+    for (auto* counters : {&total, &window})
+    {
+        counters->instructions += frame.instructions;
+        counters->framesEmulated++;
+        counters->droppedFrames += frame.emulate + frame.present > frameBudget;
+        counters->emulateSeconds += toSeconds(frame.emulate);
+        counters->presentSeconds += toSeconds(frame.present);
+        counters->sleepSeconds += toSeconds(frame.sleep);
+    }
+    totalTimerTicks += frame.timerTicks;
+    windowTimerTicks += frame.timerTicks;
+}
+
+bool Metrics::Roll(Clock::time_point now)
+{
+    total.seconds = toSeconds(now - start);
+    total.timerDrift = totalTimerTicks - timerHz * total.seconds;
+
+    if (now - windowStart < std::chrono::seconds{1})
+    {
+        return false;
+    }
+
+    window.seconds = toSeconds(now - windowStart);
+    window.timerDrift = windowTimerTicks - timerHz * window.seconds;
+    last = window;
+
+    window = {};
+    windowTimerTicks = 0;
+    windowStart = now;
+    return true;
+}
+
+std::string FormatMetricsJson(const MetricsWindow& window)
+{
+    return std::format("{{\"seconds\": {:.3f}, \"ips\": {:.0f}, \"frames_emulated\": {}, "
+                       "\"dropped_frames\": {}, \"emulate_ms\": {:.3f}, \"present_ms\": {:.3f}, "
+                       "\"sleep_ms\": {:.3f}, \"timer_drift\": {:.1f}}}",
+                       window.seconds, window.InstructionsPerSecond(), window.framesEmulated, window.droppedFrames,
+                       window.emulateSeconds * 1000, window.presentSeconds * 1000, window.sleepSeconds * 1000,
+                       window.timerDrift);
+}
+
+std::string FormatMetricsOverlay(const MetricsWindow& window)
+{
+    // Time split as a share of the window
+    auto share = [&](double seconds) { return window.seconds > 0 ? 100 * seconds / window.seconds : 0; };
+    return std::format("IPS {:.0f}\nFPS {:.0f} DROP {}\nEMU {:.1f}% PRES {:.1f}% SLEEP {:.1f}%\nTIMER DRIFT {:+.0f}",
+                       window.InstructionsPerSecond(), window.FramesPerSecond(), window.droppedFrames,
+                       share(window.emulateSeconds), share(window.presentSeconds), share(window.sleepSeconds),
+                       window.timerDrift);
+}
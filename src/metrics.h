@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Counters over a span of wall time
+struct MetricsWindow
+{
+    double seconds = 0;
+    uint64_t instructions = 0;
+    // Every emulated frame is presented, a frame that cannot be ends the loop
+    uint64_t framesEmulated = 0;
+    // Frames whose emulate and present work did not fit in the frame budget
+    uint64_t droppedFrames = 0;
+    double emulateSeconds = 0;
+    double presentSeconds = 0;
+    double sleepSeconds = 0;
+    // Timer decrements performed minus the 60 Hz a real machine would do in the same wall time
+    double timerDrift = 0;
+
+    [[nodiscard]] double InstructionsPerSecond() const;
+    [[nodiscard]] double FramesPerSecond() const;
+};
+
+// What the frontend measured for one frame
+struct FrameSample
+{
+    uint64_t instructions = 0;
+    uint64_t timerTicks = 0;
+    std::chrono::nanoseconds emulate{};
+    std::chrono::nanoseconds present{};
+    std::chrono::nanoseconds sleep{};
+};
+
+// Live counters of the frontend loop: totals since start and the last completed one second window.
+// Not thread safe, read it from the thread that runs the loop.
+class Metrics
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit Metrics(std::chrono::nanoseconds frameBudget, Clock::time_point start = Clock::now());
+
+    void AddFrame(const FrameSample& frame);
+
+    // Closes the current window once a second has passed, true when a new LastWindow is available
+    [[nodiscard]] bool Roll(Clock::time_point now = Clock::now());
+
+    [[nodiscard]] const MetricsWindow& Total() const { return total; }
+    [[nodiscard]] const MetricsWindow& LastWindow() const { return last; }
+
+private:
+    std::chrono::nanoseconds frameBudget;
+    Clock::time_point start;
+    Clock::time_point windowStart;
+    uint64_t totalTimerTicks = 0;
+    uint64_t windowTimerTicks = 0;
+    MetricsWindow total;
+    MetricsWindow window;
+    MetricsWindow last;
+};
+
+// One JSON object on a single line, for the periodic dump
+[[nodiscard]] std::string FormatMetricsJson(const MetricsWindow& window);
+
+// A few short upper case lines for the on-screen overlay
+[[nodiscard]] std::string FormatMetricsOverlay(const MetricsWindow& window);
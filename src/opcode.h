@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstdint>
+
+#include "chip8.h"
+
+// Instruction forms of the base CHIP-8 set, the SUPER-CHIP display instructions and the XO-CHIP extensions
+enum class OpcodeClass : uint8_t
+{
+    Cls,         // 00E0, any 0NN0
+    Ret,         // 00EE, any 0NNE
+    Jump,        // 1NNN
+    Call,        // 2NNN
+    SkipEqImm,   // 3XNN
+    SkipNeImm,   // 4XNN
+    SkipEqReg,   // 5XY0
+    LoadImm,     // 6XNN
+    AddImm,      // 7XNN
+    Move,        // 8XY0
+    Or,          // 8XY1
+    And,         // 8XY2
+    Xor,         // 8XY3
+    Add,         // 8XY4
+    Sub,         // 8XY5
+    ShiftRight,  // 8XY6
+    SubReverse,  // 8XY7
+    ShiftLeft,   // 8XYE
+    SkipNeReg,   // 9XY0
+    LoadI,       // ANNN
+    JumpOffset,  // BNNN
+    Random,      // CXNN
+    Draw,        // DXYN
+    SkipKey,     // EX9E
+    SkipNoKey,   // EXA1
+    GetDelay,    // FX07
+    WaitKey,     // FX0A
+    SetDelay,    // FX15
+    SetSound,    // FX18
+    AddI,        // FX1E
+    Font,        // FX29
+    Bcd,         // FX33
+    Store,       // FX55
+    Load,        // FX65
+    ScrollDown,  // 00CN
+    ScrollRight, // 00FB
+    ScrollLeft,  // 00FC
+    LowRes,      // 00FE
+    HighRes,     // 00FF
+    ScrollUp,    // 00DN
+    SaveRange,   // 5XY2
+    LoadRange,   // 5XY3
+    LoadILong,   // F000 NNNN
+    Planes,      // FN01
+    Audio,       // F002
+    Pitch,       // FX3A
+    Unknown,
+};
+
+constexpr int opcodeClassCount = static_cast<int>(OpcodeClass::Unknown) + 1;
+
+// Form of opcode under profile, as the interpreter runs it. The SUPER-CHIP and XO-CHIP instructions are Unknown to the
+// profiles that do not have them, or a clear or return when their last nibble makes them one.
+[[nodiscard]] constexpr OpcodeClass ClassifyOpcode(uint16_t opcode, QuirkProfile profile)
+{
+    const auto quirks = QuirksOf(profile);
+    const auto xo = [&](OpcodeClass form) { return quirks.xoChip ? form : OpcodeClass::Unknown; };
+
+    const auto lo = opcode & 0xff;
+    switch (opcode >> 12)
+    {
+    case 0x0:
+    {
+        if (quirks.schipDisplay && (opcode & 0xfff0) == 0x00c0)
+        {
+            return OpcodeClass::ScrollDown;
+        }
+        if (quirks.xoChip && (opcode & 0xfff0) == 0x00d0)
+        {
+            return OpcodeClass::ScrollUp;
+        }
+        if (quirks.schipDisplay)
+        {
+            switch (opcode)
+            {
+            case 0x00fb:
+                return OpcodeClass::ScrollRight;
+            case 0x00fc:
+                return OpcodeClass::ScrollLeft;
+            case 0x00fe:
+                return OpcodeClass::LowRes;
+            case 0x00ff:
+                return OpcodeClass::HighRes;
+            default:
+                break;
+            }
+        }
+        // The interpreter only looks at the last nibble of the rest
+        switch (opcode & 0xf)
+        {
+        case 0x0:
+            return OpcodeClass::Cls;
+        case 0xe:
+            return OpcodeClass::Ret;
+        default:
+            return OpcodeClass::Unknown;
+        }
+    }
+    case 0x1:
+        return OpcodeClass::Jump;
+    case 0x2:
+        return OpcodeClass::Call;
+    case 0x3:
+        return OpcodeClass::SkipEqImm;
+    case 0x4:
+        return OpcodeClass::SkipNeImm;
+    case 0x5:
+    {
+        switch (opcode & 0xf)
+        {
+        case 0x0:
+            return OpcodeClass::SkipEqReg;
+        case 0x2:
+            return xo(OpcodeClass::SaveRange);
+        case 0x3:
+            return xo(OpcodeClass::LoadRange);
+        default:
+            return OpcodeClass::Unknown;
+        }
+    }
+    case 0x6:
+        return OpcodeClass::LoadImm;
+    case 0x7:
+        return OpcodeClass::AddImm;
+    case 0x8:
+    {
+        switch (opcode & 0xf)
+        {
+        case 0x0:
+            return OpcodeClass::Move;
+        case 0x1:
+            return OpcodeClass::Or;
+        case 0x2:
+            return OpcodeClass::And;
+        case 0x3:
+            return OpcodeClass::Xor;
+        case 0x4:
+            return OpcodeClass::Add;
+        case 0x5:
+            return OpcodeClass::Sub;
+        case 0x6:
+            return OpcodeClass::ShiftRight;
+        case 0x7:
+            return OpcodeClass::SubReverse;
+        case 0xe:
+            return OpcodeClass::ShiftLeft;
+        default:
+            return OpcodeClass::Unknown;
+        }
+    }
+    case 0x9:
+        return (opcode & 0xf) == 0 ? OpcodeClass::SkipNeReg : OpcodeClass::Unknown;
+    case 0xa:
+        return OpcodeClass::LoadI;
+    case 0xb:
+        return OpcodeClass::JumpOffset;
+    case 0xc:
+        return OpcodeClass::Random;
+    case 0xd:
+        return OpcodeClass::Draw;
+    case 0xe:
+        return lo == 0x9e ? OpcodeClass::SkipKey : lo == 0xa1 ? OpcodeClass::SkipNoKey : OpcodeClass::Unknown;
+    default:
+    {
+        switch (lo)
+        {
+        case 0x00:
+            return opcode == 0xf000 ? xo(OpcodeClass::LoadILong) : OpcodeClass::Unknown;
+        case 0x01:
+            return xo(OpcodeClass::Planes);
+        case 0x02:
+            return opcode == 0xf002 ? xo(OpcodeClass::Audio) : OpcodeClass::Unknown;
+        case 0x07:
+            return OpcodeClass::GetDelay;
+        case 0x0a:
+            return OpcodeClass::WaitKey;
+        case 0x15:
+            return OpcodeClass::SetDelay;
+        case 0x18:
+            return OpcodeClass::SetSound;
+        case 0x1e:
+            return OpcodeClass::AddI;
+        case 0x29:
+            return OpcodeClass::Font;
+        case 0x33:
+            return OpcodeClass::Bcd;
+        case 0x3a:
+            return xo(OpcodeClass::Pitch);
+        case 0x55:
+            return OpcodeClass::Store;
+        case 0x65:
+            return OpcodeClass::Load;
+        default:
+            return OpcodeClass::Unknown;
+        }
+    }
+    }
+}
+
+// Bytes the instruction takes, XO-CHIP's F000 NNNN is followed by its address
+[[nodiscard]] constexpr int InstructionLength(uint16_t opcode, QuirkProfile profile)
+{
+    return QuirksOf(profile).xoChip && opcode == 0xf000 ? 4 : 2;
+}
+
+// Pattern name such as "8XY4"
+[[nodiscard]] constexpr const char* OpcodeClassName(OpcodeClass opcodeClass)
+{
+    constexpr const char* names[opcodeClassCount] = {
+        "00E0", "00EE", "1NNN", "2NNN", "3XNN", "4XNN", "5XY0", "6XNN", "7XNN", "8XY0", "8XY1", "8XY2",
+        "8XY3", "8XY4", "8XY5", "8XY6", "8XY7", "8XYE", "9XY0", "ANNN", "BNNN", "CXNN", "DXYN", "EX9E",
+        "EXA1", "FX07", "FX0A", "FX15", "FX18", "FX1E", "FX29", "FX33", "FX55", "FX65", "00CN", "00FB",
+        "00FC", "00FE", "00FF", "00DN", "5XY2", "5XY3", "F000", "FN01", "F002", "FX3A", "????",
+    };
+    return names[static_cast<int>(opcodeClass)];
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+[[nodiscard]] inline unsigned DefaultThreadCount() { return std::max(1u, std::thread::hardware_concurrency()); }
+
+// Calls fn(index, worker) for every index in [0, count), spread over up to `threads` workers.
+// Passing 0 threads uses every core. The calling thread is worker 0.
+template <typename Fn>
+void ParallelFor(size_t count, unsigned threads, Fn&& fn)
+{
+    if (threads == 0)
+    {
+        threads = DefaultThreadCount();
+    }
+    threads = static_cast<unsigned>(std::min<size_t>(threads, count));
+
+    std::atomic<size_t> next{0};
+    auto work = [&](unsigned worker)
+    {
+        for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count;
+             i = next.fetch_add(1, std::memory_order_relaxed))
+        {
+            fn(i, worker);
+        }
+    };
+
+    if (threads <= 1)
+    {
+        work(0);
+        return;
+    }
+
+    std::vector<std::jthread> workers;
+    for (unsigned worker = 1; worker < threads; worker++)
+    {
+        workers.emplace_back(work, worker);
+    }
+    work(0);
+}
+
+// Persistent version of ParallelFor for callers that fan out many small batches,
+// e.g. one batch per emulated frame, where starting threads every time would dominate.
+class WorkerPool
+{
+public:
+    explicit WorkerPool(unsigned threads = 0)
+    {
+        if (threads == 0)
+        {
+            threads = DefaultThreadCount();
+        }
+
+        for (unsigned worker = 1; worker < threads; worker++)
+        {
+            workers.emplace_back([this, worker] { workerLoop(worker); });
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard lock{mutex};
+            stopping = true;
+            generation++;
+        }
+        wake.notify_all();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    [[nodiscard]] unsigned Size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Same contract as ParallelFor, blocks until every index has been processed
+    template <typename Fn>
+    void Run(size_t count, Fn&& fn)
+    {
+        if (workers.empty() || count <= 1)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                fn(i, 0u);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard lock{mutex};
+            jobContext = &fn;
+            jobThunk = [](void* context, size_t index, unsigned worker)
+            { (*static_cast<std::remove_reference_t<Fn>*>(context))(index, worker); };
+            jobCount = count;
+            next.store(0, std::memory_order_relaxed);
+            busy = static_cast<unsigned>(workers.size());
+            generation++;
+        }
+        wake.notify_all();
+
+        runJob(0);
+
+        std::unique_lock lock{mutex};
+        done.wait(lock, [this] { return busy == 0; });
+    }
+
+private:
+    void runJob(unsigned worker)
+    {
+        for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < jobCount;
+             i = next.fetch_add(1, std::memory_order_relaxed))
+        {
+            jobThunk(jobContext, i, worker);
+        }
+    }
+
+    void workerLoop(unsigned worker)
+    {
+        uint64_t seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock lock{mutex};
+                wake.wait(lock, [&] { return generation != seen; });
+                seen = generation;
+                if (stopping)
+                {
+                    return;
+                }
+            }
+
+            runJob(worker);
+
+            std::lock_guard lock{mutex};
+            if (--busy == 0)
+            {
+                done.notify_one();
+            }
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    uint64_t generation = 0;
+    unsigned busy = 0;
+    bool stopping = false;
+
+    void* jobContext = nullptr;
+    void (*jobThunk)(void*, size_t, unsigned) = nullptr;
+    size_t jobCount = 0;
+    std::atomic<size_t> next{0};
+
+    // Declared last so the threads are joined before the state above is destroyed
+    std::vector<std::jthread> workers;
+};
@@ -5,5 +5,11 @@
 #include "chip8.h"
 
 [[nodiscard]] bool platform_create_window(const std::string& title, const int width, const int height);
-[[nodiscard]] bool platform_update_window(const uint32_t (&buffer)[chip8Width * chip8Height]);
+// Render target without a visible window, used to benchmark presenting frames
+[[nodiscard]] bool platform_create_offscreen(const int width, const int height);
+// Presents videoWidth x videoHeight pixels, row after row, scaled to the window with a single upload. The overlay set
+// below is drawn on top. False when the window was closed or cannot be drawn to, nothing is presented then.
+[[nodiscard]] bool platform_update_window(const uint32_t* videoBuffer, int videoWidth, int videoHeight);
+// Text drawn over the top left of every following frame, empty to remove it
+void platform_set_overlay(const std::string& text);
 void platform_close_window();
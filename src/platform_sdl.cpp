@@ -1,13 +1,21 @@
 #include "platform.h"
 #include "input.h"
+#include "present.h"
 
 #include <format>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include <SDL2/SDL.h>
 
 SDL_Window* window;
+SDL_Surface* surface;
 SDL_Renderer* renderer;
+// Window sized frame uploaded with one SDL_UpdateTexture
+SDL_Texture* texture;
+std::vector<uint32_t> pixels;
+std::string overlay;
 
 int width;
 int height;
@@ -37,7 +45,29 @@ bool platform_create_window(const std::string& title, const int w, const int h)
     return true;
 }
 
-bool platform_update_window(const uint32_t (&videoBuffer)[chip8Width * chip8Height])
+bool platform_create_offscreen(const int w, const int h)
+{
+    surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA8888);
+    if (surface == nullptr)
+    {
+        std::cout << std::format("Unable to create SDL surface: {}\n", SDL_GetError());
+        return false;
+    }
+
+    renderer = SDL_CreateSoftwareRenderer(surface);
+    if (renderer == nullptr)
+    {
+        std::cout << std::format("Unable to create SDL renderer: {}\n", SDL_GetError());
+        return false;
+    }
+
+    width = w;
+    height = h;
+
+    return true;
+}
+
+bool platform_update_window(const uint32_t* videoBuffer, int videoWidth, int videoHeight)
 {
     SDL_Event event;
     while (SDL_PollEvent(&event))
@@ -64,40 +94,43 @@ bool platform_update_window(const uint32_t (&videoBuffer)[chip8Width * chip8Heig
         }
     }
 
-    const int xScale = width / chip8Width;
-    const int yScale = height / chip8Height;
-
-    for (int y = 0; y < chip8Height; y++)
+    if (texture == nullptr)
     {
-        for (int x = 0; x < chip8Width; x++)
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGB888, SDL_TEXTUREACCESS_STREAMING, width, height);
+        if (texture == nullptr)
         {
-            const auto pixelColor = videoBuffer[y * chip8Width + x];
-            SDL_Rect rc;
-            rc.x = x * xScale;
-            rc.y = y * yScale;
-            rc.w = xScale;
-            rc.h = yScale;
-
-            const auto r = (pixelColor >> 16) & 0xff;
-            const auto g = (pixelColor >> 8) & 0xff;
-            const auto b = pixelColor & 0xff;
-
-            SDL_SetRenderDrawColor(renderer, r, g, b, 255);
-            SDL_RenderFillRect(renderer, &rc);
+            std::cout << std::format("Unable to create SDL texture: {}\n", SDL_GetError());
+            return false;
         }
+        pixels.assign(static_cast<size_t>(width) * height, 0);
     }
 
+    ScaleVideo(videoBuffer, videoWidth, videoHeight, pixels.data(), width, height);
+    DrawOverlay(pixels.data(), width, height, overlay);
+    SDL_UpdateTexture(texture, nullptr, pixels.data(), width * sizeof(uint32_t));
+    SDL_RenderCopy(renderer, texture, nullptr, nullptr);
     SDL_RenderPresent(renderer);
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_RenderClear(renderer);
 
     return true;
 }
 
+void platform_set_overlay(const std::string& text) { overlay = text; }
+
 void platform_close_window()
 {
+    if (texture != nullptr)
+    {
+        SDL_DestroyTexture(texture);
+    }
     SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
+    if (window != nullptr)
+    {
+        SDL_DestroyWindow(window);
+    }
+    if (surface != nullptr)
+    {
+        SDL_FreeSurface(surface);
+    }
 }
 
 int toggleKey(int scancode, bool pressed)
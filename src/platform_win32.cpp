@@ -12,6 +12,7 @@ int width = 800;
 int height = 600;
 
 Chip8 chip8{};
+uint32_t videoBuffer[hiresWidth * hiresHeight]{};
 constexpr auto execPerTick = 12;
 
 // Helper for handling errors of window api
@@ -38,29 +39,18 @@ LRESULT CALLBACK WndProc(HWND window,    // handle to window
         PAINTSTRUCT paint;
         HDC deviceContext = BeginPaint(window, &paint);
         {
-            const auto xScale = width / chip8Width;
-            const auto yScale = height / chip8Height;
-
-            for (int y = 0; y < chip8Height; y++)
-            {
-                for (int x = 0; x < chip8Width; x++)
-                {
-                    const auto pixelColor = chip8.videoBuffer[y * chip8Width + x];
-                    RECT rect;
-                    rect.left = x * xScale;
-                    rect.top = y * yScale;
-                    rect.right = rect.left + xScale;
-                    rect.bottom = rect.top + yScale;
-
-                    const auto r = (pixelColor >> 16) & 0xff;
-                    const auto g = (pixelColor >> 8) & 0xff;
-                    const auto b = pixelColor & 0xff;
-                    HBRUSH brush = CreateSolidBrush(RGB(r, g, b));
-
-                    FillRect(deviceContext, &rect, brush);
-                    DeleteObject(brush);
-                }
-            }
+            // Whole frame in one call, 0x00RRGGBB is a top-down 32-bit DIB
+            BITMAPINFO bitmap = {};
+            bitmap.bmiHeader.biSize = sizeof(bitmap.bmiHeader);
+            bitmap.bmiHeader.biWidth = chip8.DisplayWidth();
+            bitmap.bmiHeader.biHeight = -chip8.DisplayHeight();
+            bitmap.bmiHeader.biPlanes = 1;
+            bitmap.bmiHeader.biBitCount = 32;
+            bitmap.bmiHeader.biCompression = BI_RGB;
+
+            SetStretchBltMode(deviceContext, COLORONCOLOR);
+            StretchDIBits(deviceContext, 0, 0, width, height, 0, 0, chip8.DisplayWidth(), chip8.DisplayHeight(),
+                          videoBuffer, &bitmap, DIB_RGB_COLORS, SRCCOPY);
         }
         EndPaint(window, &paint);
         return 0;
@@ -117,9 +107,9 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int n
     std::wstring romPathArg = args[1];
     std::string romPath(romPathArg.begin(), romPathArg.end());
 
-    if (!chip8.LoadRom(romPath))
+    if (const auto error = chip8.LoadRom(romPath); error != RomError::None)
     {
-        std::string errMsg = std::format("Rom {} not found\n", romPath);
+        std::string errMsg = std::format("Rom {}: {}\n", romPath, RomErrorMessage(error));
         MessageBox(NULL, errMsg.c_str(), "Error", MB_OK);
         return 1;
     }
@@ -171,13 +161,19 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int n
         {
             auto frameStart = std::chrono::high_resolution_clock::now();
 
+            for (int key = 0; key < KEY_CODE_COUNT; key++)
+            {
+                chip8.SetKey(key, IsKeyPressed(key));
+            }
+
             for (int i = 0; i < 30; i++)
             {
                 chip8.ExecuteNext();
             }
+            chip8.RenderVideo(videoBuffer);
 
             // Redraw
-            InvalidateRect(window, NULL, true);
+            InvalidateRect(window, NULL, false);
 
             std::chrono::duration<float, std::milli> frameDuration =
                 std::chrono::high_resolution_clock::now() - frameStart;
@@ -1,19 +1,30 @@
 #include "chip8.h"
 #include "input.h"
 #include "platform.h"
+#include "present.h"
 
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <X11/keysymdef.h>
 
 #include <iostream>
+#include <string>
+#include <vector>
 
 Display* display;
 Window window;
+Pixmap pixmap;
+// Window or offscreen pixmap
+Drawable target;
 GC gc;
 int width;
 int height;
 
+// Window sized frame uploaded with one XPutImage, rebuilt when the size changes
+XImage* image;
+std::vector<uint32_t> pixels;
+std::string overlay;
+
 // Input handling helper
 int toggleKey(int keysym, bool pressed);
 
@@ -69,12 +80,32 @@ bool platform_create_window(const std::string& title, const int w, const int h)
     }
 
     gc = XCreateGC(display, window, 0, nullptr);
+    target = window;
     return true;
 }
 
-bool platform_update_window(const uint32_t (&videoBuffer)[chip8Width * chip8Height])
+bool platform_create_offscreen(const int w, const int h)
 {
-    if (XPending(display))
+    display = XOpenDisplay(NULL);
+    if (display == nullptr)
+    {
+        std::cout << "Unable to open X11 display\n";
+        return false;
+    }
+
+    const int screenNumber = DefaultScreen(display);
+    width = w;
+    height = h;
+    pixmap = XCreatePixmap(display, RootWindow(display, screenNumber), width, height,
+                           DefaultDepth(display, screenNumber));
+    gc = XCreateGC(display, pixmap, 0, nullptr);
+    target = pixmap;
+    return true;
+}
+
+bool platform_update_window(const uint32_t* videoBuffer, int videoWidth, int videoHeight)
+{
+    while (XPending(display))
     {
         XEvent event;
         XNextEvent(display, &event);
@@ -95,8 +126,13 @@ bool platform_update_window(const uint32_t (&videoBuffer)[chip8Width * chip8Heig
         }
         case Expose:
         {
-            width = event.xexpose.width;
-            height = event.xexpose.height;
+            // The event only carries the exposed area
+            XWindowAttributes attributes;
+            if (XGetWindowAttributes(display, window, &attributes))
+            {
+                width = attributes.width;
+                height = attributes.height;
+            }
             break;
         }
         case DestroyNotify:
@@ -105,29 +141,63 @@ bool platform_update_window(const uint32_t (&videoBuffer)[chip8Width * chip8Heig
             return false;
         }
         }
-
-        return true;
     }
 
-    const int xScale = width / chip8Width;
-    const int yScale = height / chip8Height;
-
-    for (int y = 0; y < chip8Height; y++)
+    if (image == nullptr || image->width != width || image->height != height)
     {
-        for (int x = 0; x < chip8Width; x++)
+        if (image != nullptr)
         {
-            const auto pixelColor = videoBuffer[y * chip8Width + x];
-            XSetForeground(display, gc, pixelColor);
-            XFillRectangle(display, window, gc, x * xScale, y * yScale, xScale, yScale);
+            // The pixels belong to the vector
+            image->data = nullptr;
+            XDestroyImage(image);
         }
+
+        const int screenNumber = DefaultScreen(display);
+        pixels.assign(static_cast<size_t>(width) * height, 0);
+        image = XCreateImage(display, DefaultVisual(display, screenNumber), DefaultDepth(display, screenNumber),
+                             ZPixmap, 0, reinterpret_cast<char*>(pixels.data()), width, height, 32, 0);
+        if (image == nullptr)
+        {
+            std::cout << "Unable to create X11 image\n";
+            return false;
+        }
+    }
+
+    ScaleVideo(videoBuffer, videoWidth, videoHeight, pixels.data(), width, height);
+    DrawOverlay(pixels.data(), width, height, overlay);
+    XPutImage(display, target, gc, image, 0, 0, 0, 0, width, height);
+
+    if (target == pixmap)
+    {
+        // Nothing else drives the connection offscreen, wait for the server to draw the frame
+        XSync(display, False);
+    }
+    else
+    {
+        XFlush(display);
     }
 
     return true;
 }
 
+void platform_set_overlay(const std::string& text) { overlay = text; }
+
 void platform_close_window()
 {
-    XDestroyWindow(display, window);
+    if (image != nullptr)
+    {
+        image->data = nullptr;
+        XDestroyImage(image);
+        image = nullptr;
+    }
+    if (target == pixmap)
+    {
+        XFreePixmap(display, pixmap);
+    }
+    else
+    {
+        XDestroyWindow(display, window);
+    }
     XCloseDisplay(display);
 }
 
@@ -0,0 +1,114 @@
+#include "present.h"
+
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+namespace
+{
+constexpr int glyphWidth = 3;
+constexpr int glyphHeight = 5;
+constexpr uint32_t overlayText = 0x00ffd040;
+constexpr uint32_t overlayBackground = 0x00101010;
+
+// Five rows of three pixels, top row in the high bits
+constexpr std::pair<char, uint16_t> font[] = {
+    {'0', 0b111'101'101'101'111}, {'1', 0b010'110'010'010'111}, {'2', 0b111'001'111'100'111},
+    {'3', 0b111'001'111'001'111}, {'4', 0b101'101'111'001'001}, {'5', 0b111'100'111'001'111},
+    {'6', 0b111'100'111'101'111}, {'7', 0b111'001'010'010'010}, {'8', 0b111'101'111'101'111},
+    {'9', 0b111'101'111'001'111}, {'A', 0b010'101'111'101'101}, {'B', 0b110'101'110'101'110},
+    {'C', 0b011'100'100'100'011}, {'D', 0b110'101'101'101'110}, {'E', 0b111'100'110'100'111},
+    {'F', 0b111'100'110'100'100}, {'G', 0b011'100'101'101'011}, {'H', 0b101'101'111'101'101},
+    {'I', 0b111'010'010'010'111}, {'J', 0b001'001'001'101'010}, {'K', 0b101'101'110'101'101},
+    {'L', 0b100'100'100'100'111}, {'M', 0b101'111'111'101'101}, {'N', 0b110'101'101'101'101},
+    {'O', 0b010'101'101'101'010}, {'P', 0b110'101'110'100'100}, {'Q', 0b010'101'101'110'011},
+    {'R', 0b110'101'110'101'101}, {'S', 0b011'100'010'001'110}, {'T', 0b111'010'010'010'010},
+    {'U', 0b101'101'101'101'111}, {'V', 0b101'101'101'101'010}, {'W', 0b101'101'111'111'101},
+    {'X', 0b101'101'010'101'101}, {'Y', 0b101'101'010'010'010}, {'Z', 0b111'001'010'100'111},
+    {'.', 0b000'000'000'000'010}, {'/', 0b001'001'010'100'100}, {'+', 0b000'010'111'010'000},
+    {'-', 0b000'000'111'000'000}, {':', 0b000'010'000'010'000}, {'%', 0b101'001'010'100'101},
+};
+
+uint16_t glyph(char c)
+{
+    const auto upper = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    for (const auto& [character, bits] : font)
+    {
+        if (character == upper)
+        {
+            return bits;
+        }
+    }
+    return 0;
+}
+
+void fill(uint32_t* image, int width, int height, int x, int y, int w, int h, uint32_t color)
+{
+    for (int row = std::max(0, y); row < std::min(height, y + h); row++)
+    {
+        std::fill(image + row * width + std::max(0, x), image + row * width + std::min(width, x + w), color);
+    }
+}
+}  // namespace
+
+void ScaleVideo(const uint32_t* videoBuffer, int videoWidth, int videoHeight, uint32_t* image, int width, int height)
+{
+    for (int y = 0; y < height; y++)
+    {
+        const auto* source = &videoBuffer[(y * videoHeight / height) * videoWidth];
+        auto* target = image + y * width;
+        for (int x = 0; x < width; x++)
+        {
+            target[x] = source[x * videoWidth / width];
+        }
+    }
+}
+
+void DrawOverlay(uint32_t* image, int width, int height, const std::string& text)
+{
+    if (text.empty())
+    {
+        return;
+    }
+
+    // Readable at any window size without covering much of the game
+    const int scale = std::max(1, height / 200);
+    const int advance = (glyphWidth + 1) * scale;
+    const int lineHeight = (glyphHeight + 2) * scale;
+
+    int columns = 0;
+    int lines = 1;
+    int column = 0;
+    for (const auto c : text)
+    {
+        column = c == '\n' ? 0 : column + 1;
+        lines += c == '\n';
+        columns = std::max(columns, column);
+    }
+    fill(image, width, height, 0, 0, columns * advance + 3 * scale, lines * lineHeight + 2 * scale, overlayBackground);
+
+    int x = 2 * scale;
+    int y = 2 * scale;
+    for (const auto c : text)
+    {
+        if (c == '\n')
+        {
+            x = 2 * scale;
+            y += lineHeight;
+            continue;
+        }
+
+        const auto bits = glyph(c);
+        for (int row = 0; row < glyphHeight; row++)
+        {
+            for (int bit = 0; bit < glyphWidth; bit++)
+            {
+                if (bits & (1 << ((glyphHeight - 1 - row) * glyphWidth + (glyphWidth - 1 - bit))))
+                {
+                    fill(image, width, height, x + bit * scale, y + row * scale, scale, scale, overlayText);
+                }
+            }
+        }
+        x += advance;
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "chip8.h"
+
+// CPU side of presenting a frame. Backends scale the video buffer into an image of the window size, draw the overlay
+// into it and upload the result with a single call.
+
+// Nearest-neighbour scale of videoWidth x videoHeight pixels to width x height, one 0x00RRGGBB word per pixel. The
+// display mode can change between frames.
+void ScaleVideo(const uint32_t* videoBuffer, int videoWidth, int videoHeight, uint32_t* image, int width, int height);
+
+// Text on a dark box at the top left of the image, lines split on '\n'. The 3x5 font has digits, upper case letters
+// (lower case is drawn upper case) and . / + - : %, anything else is blank.
+void DrawOverlay(uint32_t* image, int width, int height, const std::string& text);
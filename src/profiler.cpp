@@ -0,0 +1,189 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <format>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+
+Profiler::Profiler(uint32_t sampleInterval)
+    : sampleInterval(std::max(1u, sampleInterval)), untilSample(std::max(1u, sampleInterval))
+{
+    nodes.push_back({0, 0, {}, {}});
+}
+
+uint32_t Profiler::child(uint32_t node, uint16_t address)
+{
+    for (const auto& [childAddress, index] : nodes[node].children)
+    {
+        if (childAddress == address)
+        {
+            return index;
+        }
+    }
+
+    const auto index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back({address, node, {}, {}});
+    nodes[node].children.emplace_back(address, index);
+    return index;
+}
+
+void Profiler::Record(const Chip8& chip8, QuirkProfile profile)
+{
+    const auto pc = chip8.pc;
+    const auto opcode = chip8.NextOpcode(profile);
+    const auto opcodeClass = ClassifyOpcode(opcode, profile);
+
+    if (--untilSample == 0)
+    {
+        untilSample = sampleInterval;
+        samples++;
+        // XO-CHIP code past 4 KiB is only counted per opcode class and subroutine
+        if (pc < chip8MemorySize)
+        {
+            pcCounts[pc]++;
+            pcOpcodes[pc] = opcode;
+        }
+        opcodeCounts[static_cast<int>(opcodeClass)]++;
+        nodes[current].self[static_cast<int>(opcodeClass)]++;
+    }
+
+    // The instruction is charged to the caller, the callee starts at its first instruction
+    if (opcodeClass == OpcodeClass::Call && depth < maxDepth)
+    {
+        current = child(current, opcode & 0xfff);
+        depth++;
+    }
+    else if (opcodeClass == OpcodeClass::Ret && depth > 0)
+    {
+        current = nodes[current].parent;
+        depth--;
+    }
+}
+
+void Profiler::Run(Chip8& chip8, QuirkProfile profile, int count)
+{
+    auto run = [&]<QuirkProfile p>()
+    {
+        for (int i = 0; i < count; i++)
+        {
+            Step<p>(chip8);
+        }
+    };
+
+    switch (profile)
+    {
+    case QuirkProfile::Cosmac:
+        run.operator()<QuirkProfile::Cosmac>();
+        break;
+    case QuirkProfile::SuperChip:
+        run.operator()<QuirkProfile::SuperChip>();
+        break;
+    case QuirkProfile::XoChip:
+        run.operator()<QuirkProfile::XoChip>();
+        break;
+    default:
+        run.operator()<QuirkProfile::Default>();
+        break;
+    }
+}
+
+void Profiler::WriteCollapsed(std::ostream& out) const
+{
+    for (uint32_t index = 0; index < nodes.size(); index++)
+    {
+        const auto& node = nodes[index];
+        if (std::accumulate(node.self.begin(), node.self.end(), uint64_t{0}) == 0)
+        {
+            continue;
+        }
+
+        std::string stack;
+        for (auto walk = index; walk != 0; walk = nodes[walk].parent)
+        {
+            stack = std::format(";sub_{:03x}", nodes[walk].address) + stack;
+        }
+        stack = "main" + stack;
+
+        for (int opcodeClass = 0; opcodeClass < opcodeClassCount; opcodeClass++)
+        {
+            if (node.self[opcodeClass])
+            {
+                out << std::format("{};{} {}\n", stack, OpcodeClassName(static_cast<OpcodeClass>(opcodeClass)),
+                                   node.self[opcodeClass]);
+            }
+        }
+    }
+}
+
+void Profiler::WriteReport(std::ostream& out, size_t top) const
+{
+    const auto total = std::max<uint64_t>(1, samples);
+    auto percent = [&](uint64_t count) { return 100.0 * static_cast<double>(count) / static_cast<double>(total); };
+
+    out << std::format("{} instructions sampled (1 in {})\n\n", samples, sampleInterval);
+
+    std::vector<uint16_t> pcs;
+    for (uint16_t pc = 0; pc < pcCounts.size(); pc++)
+    {
+        if (pcCounts[pc])
+        {
+            pcs.push_back(pc);
+        }
+    }
+    std::sort(pcs.begin(), pcs.end(), [&](auto a, auto b) { return pcCounts[a] > pcCounts[b]; });
+    out << "pc        count       %  opcode\n";
+    for (size_t i = 0; i < std::min(top, pcs.size()); i++)
+    {
+        out << std::format("{:03x}  {:10}  {:6.2f}  {:04x}\n", pcs[i], pcCounts[pcs[i]], percent(pcCounts[pcs[i]]),
+                           pcOpcodes[pcs[i]]);
+    }
+
+    std::vector<int> classes(opcodeClassCount);
+    std::iota(classes.begin(), classes.end(), 0);
+    std::sort(classes.begin(), classes.end(), [&](int a, int b) { return opcodeCounts[a] > opcodeCounts[b]; });
+    out << "\nclass        count       %\n";
+    for (const auto opcodeClass : classes)
+    {
+        if (opcodeCounts[opcodeClass])
+        {
+            out << std::format("{}  {:10}  {:6.2f}\n", OpcodeClassName(static_cast<OpcodeClass>(opcodeClass)),
+                               opcodeCounts[opcodeClass], percent(opcodeCounts[opcodeClass]));
+        }
+    }
+
+    // Per subroutine: self sums every node of that address, inclusive counts a sample once even under recursion
+    struct Totals
+    {
+        uint64_t self = 0;
+        uint64_t inclusive = 0;
+    };
+    std::unordered_map<uint16_t, Totals> subroutines;
+    for (uint32_t index = 1; index < nodes.size(); index++)
+    {
+        const auto self = std::accumulate(nodes[index].self.begin(), nodes[index].self.end(), uint64_t{0});
+        subroutines[nodes[index].address].self += self;
+
+        std::vector<uint16_t> seen;
+        for (auto walk = index; walk != 0; walk = nodes[walk].parent)
+        {
+            const auto address = nodes[walk].address;
+            if (std::find(seen.begin(), seen.end(), address) == seen.end())
+            {
+                seen.push_back(address);
+                subroutines[address].inclusive += self;
+            }
+        }
+    }
+
+    std::vector<std::pair<uint16_t, Totals>> sorted(subroutines.begin(), subroutines.end());
+    std::sort(sorted.begin(), sorted.end(),
+              [](const auto& a, const auto& b) { return a.second.inclusive > b.second.inclusive; });
+    out << "\nsubroutine inclusive       %        self       %\n";
+    for (size_t i = 0; i < std::min(top, sorted.size()); i++)
+    {
+        const auto& [address, totals] = sorted[i];
+        out << std::format("sub_{:03x}   {:10}  {:6.2f}  {:10}  {:6.2f}\n", address, totals.inclusive,
+                           percent(totals.inclusive), totals.self, percent(totals.self));
+    }
+}
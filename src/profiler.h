@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "chip8.h"
+#include "opcode.h"
+
+// Counts emulated instructions per pc, per opcode class and per call stack.
+//
+// The profiler wraps the step instead of hooking into the interpreter, so machines that are not profiled run the
+// plain ExecuteNext and pay nothing. Subroutines are tracked by following 2NNN and 00EE. Every instruction is
+// attributed one cycle, the same unit cyclesPerFrame counts in.
+//
+// With a sample interval above 1 only every n-th instruction is counted, calls and returns are still followed.
+class Profiler
+{
+public:
+    explicit Profiler(uint32_t sampleInterval = 1);
+
+    // Account for the instruction chip8 is about to execute under profile
+    void Record(const Chip8& chip8, QuirkProfile profile);
+
+    template <QuirkProfile profile = QuirkProfile::Default>
+    void Step(Chip8& chip8)
+    {
+        Record(chip8, profile);
+        chip8.ExecuteNext<profile>();
+    }
+
+    // Profiled counterpart of Chip8::Run
+    void Run(Chip8& chip8, QuirkProfile profile, int count);
+
+    [[nodiscard]] uint64_t Samples() const { return samples; }
+    [[nodiscard]] uint64_t PcCount(uint16_t pc) const { return pcCounts[pc & 0xfff]; }
+    [[nodiscard]] uint64_t OpcodeCount(OpcodeClass opcodeClass) const
+    {
+        return opcodeCounts[static_cast<int>(opcodeClass)];
+    }
+
+    // Collapsed stacks for flamegraph.pl / speedscope / inferno: "main;sub_2a4;DXYN 1234" per line
+    void WriteCollapsed(std::ostream& out) const;
+
+    // Top pcs, opcode classes and subroutines (self and inclusive) as a text table
+    void WriteReport(std::ostream& out, size_t top = 20) const;
+
+private:
+    struct Node
+    {
+        uint16_t address;
+        uint32_t parent;
+        std::vector<std::pair<uint16_t, uint32_t>> children;
+        std::array<uint64_t, opcodeClassCount> self{};
+    };
+
+    // Recursion deeper than this is folded into the deepest frame
+    static constexpr size_t maxDepth = 64;
+
+    uint32_t child(uint32_t node, uint16_t address);
+
+    uint32_t sampleInterval;
+    uint32_t untilSample;
+    uint64_t samples = 0;
+
+    std::array<uint64_t, 4096> pcCounts{};
+    // Last opcode seen at each pc, self-modifying code shows its latest form
+    std::array<uint16_t, 4096> pcOpcodes{};
+    std::array<uint64_t, opcodeClassCount> opcodeCounts{};
+
+    // Call tree, node 0 is the code outside any subroutine
+    std::vector<Node> nodes;
+    uint32_t current = 0;
+    size_t depth = 0;
+};
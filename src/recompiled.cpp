@@ -0,0 +1,31 @@
+#include "recompiled.h"
+
+#include <vector>
+
+namespace
+{
+// Function local so registration order between translation units does not matter
+std::vector<RecompiledProgram>& registry()
+{
+    static std::vector<RecompiledProgram> programs;
+    return programs;
+}
+}  // namespace
+
+bool RegisterRecompiled(const RecompiledProgram& program)
+{
+    registry().push_back(program);
+    return true;
+}
+
+const RecompiledProgram* FindRecompiled(const Sha1Digest& sha1, QuirkProfile profile)
+{
+    for (const auto& program : registry())
+    {
+        if (program.sha1 == sha1 && program.profile == profile)
+        {
+            return &program;
+        }
+    }
+    return nullptr;
+}
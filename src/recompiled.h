@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+#include "chip8.h"
+#include "sha1.h"
+
+// A ROM translated ahead of time by chip8_recompile.
+//
+// Every basic block found by AnalyzeProgram becomes a C++ function. run dispatches on pc: a block runs natively when
+// the whole block fits in the remaining count and its bytes still match the ROM, anything else (BNNN targets inside a
+// block, rewritten code, unknown opcodes) runs one instruction on the interpreter. The result is the same as
+// Chip8::Run with the profile the ROM was translated for.
+struct RecompiledProgram
+{
+    const char* name = "";
+    Sha1Digest sha1{};
+    QuirkProfile profile = QuirkProfile::Default;
+    void (*run)(Chip8& chip8, int count) = nullptr;
+};
+
+// Called by the generated files during static initialization, they are linked as objects so none is dropped
+bool RegisterRecompiled(const RecompiledProgram& program);
+
+// Translation of the ROM with this digest for profile, nullptr when none is linked in
+[[nodiscard]] const RecompiledProgram* FindRecompiled(const Sha1Digest& sha1, QuirkProfile profile);
+
+// Helpers for the generated code, each does what Chip8::ExecuteNext does for the instruction
+
+inline void RecompiledTick(Chip8& chip8)
+{
+    chip8.timerTicks += (chip8.rdelay | chip8.rsound) != 0;
+    if (chip8.rdelay > 0)
+    {
+        chip8.rdelay--;
+    }
+    if (chip8.rsound > 0)
+    {
+        chip8.rsound--;
+    }
+}
+
+inline uint8_t RecompiledRandom(Chip8& chip8)
+{
+    // xorshift32, same sequence as Chip8
+    chip8.rng ^= chip8.rng << 13;
+    chip8.rng ^= chip8.rng >> 17;
+    chip8.rng ^= chip8.rng << 5;
+    return chip8.rng & 0xff;
+}
+
+// FX0A, false while no key is down
+inline bool RecompiledWaitKey(Chip8& chip8, int x)
+{
+    for (int key = 0; key < inputKeyCount; key++)
+    {
+        if (chip8.KeyDown(key))
+        {
+            chip8.regs[x] = key;
+            return true;
+        }
+    }
+    return false;
+}
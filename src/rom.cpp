@@ -0,0 +1,85 @@
+#include "rom.h"
+
+#include <utility>
+
+#if defined(_WIN32)
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+RomError ReadRomFile(const std::string& path, RomImage& image, QuirkProfile profile)
+{
+    const auto limit = static_cast<size_t>(MaxRomSize(profile));
+    // One byte more than fits, so oversized files are caught without asking for the size first. image is left alone
+    // until the read succeeded.
+    std::vector<uint8_t> bytes(limit + 1);
+
+#if defined(_WIN32)
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return RomError::OpenFailed;
+    }
+    const auto size = std::fread(bytes.data(), 1, bytes.size(), file);
+    const bool failed = std::ferror(file);
+    std::fclose(file);
+    if (failed)
+    {
+        return RomError::ReadFailed;
+    }
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return RomError::OpenFailed;
+    }
+    // A short read on a regular file means end of file
+    const auto size = read(fd, bytes.data(), bytes.size());
+    close(fd);
+    if (size < 0)
+    {
+        return RomError::ReadFailed;
+    }
+#endif
+
+    if (static_cast<size_t>(size) > limit)
+    {
+        return RomError::TooLarge;
+    }
+
+    bytes.resize(static_cast<size_t>(size));
+    image.sha1 = Sha1(bytes.data(), bytes.size());
+    image.bytes = std::move(bytes);
+    return RomError::None;
+}
+
+std::shared_ptr<const RomImage> RomCache::Load(const std::string& path, RomError& error, QuirkProfile profile)
+{
+    {
+        std::lock_guard lock{mutex};
+        if (const auto found = images.find(path); found != images.end())
+        {
+            error = RomError::None;
+            return found->second;
+        }
+    }
+
+    // Read outside the lock, two threads racing on the same new path both read it and the first insert wins
+    auto image = std::make_shared<RomImage>();
+    error = ReadRomFile(path, *image, profile);
+    if (error != RomError::None)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard lock{mutex};
+    return images.emplace(path, std::move(image)).first->second;
+}
+
+size_t RomCache::Size() const
+{
+    std::lock_guard lock{mutex};
+    return images.size();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "chip8.h"
+#include "sha1.h"
+
+// ROM image that passed validation, immutable once read
+struct RomImage
+{
+    std::vector<uint8_t> bytes;
+    Sha1Digest sha1{};
+
+    [[nodiscard]] std::span<const uint8_t> Bytes() const { return bytes; }
+};
+
+// Reads the whole file with one read call. Images larger than MaxRomSize(profile) are rejected. image only changes on
+// success.
+[[nodiscard]] RomError ReadRomFile(const std::string& path, RomImage& image,
+                                   QuirkProfile profile = QuirkProfile::Default);
+
+// Reads every distinct ROM path once and hands out the same image to every caller. Thread-safe.
+class RomCache
+{
+public:
+    // nullptr and error set on failure, failures are not cached. Images are read with the limit of profile, the
+    // largest for xochip.
+    [[nodiscard]] std::shared_ptr<const RomImage> Load(const std::string& path, RomError& error,
+                                                       QuirkProfile profile = QuirkProfile::Default);
+
+    [[nodiscard]] size_t Size() const;
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const RomImage>> images;
+};
@@ -0,0 +1,334 @@
+#include "romdb.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+constexpr char indexMagic[4] = {'C', '8', 'D', 'B'};
+constexpr uint32_t indexVersion = 1;
+
+struct RomIndexHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t count;
+};
+
+struct RomIndexReward
+{
+    uint16_t address;
+    uint16_t reserved;
+    float scale;
+};
+
+bool parseField(const std::string& field, RomDbEntry& entry)
+{
+    const auto equals = field.find('=');
+    if (equals == std::string::npos)
+    {
+        return false;
+    }
+    const auto key = field.substr(0, equals);
+    const auto value = field.substr(equals + 1);
+
+    if (key == "hz")
+    {
+        const auto hz = std::atoi(value.c_str());
+        entry.hz = static_cast<uint16_t>(hz);
+        return hz > 0 && hz <= 0xffff;
+    }
+    if (key == "keys")
+    {
+        if (value.size() != entry.keymap.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < value.size(); i++)
+        {
+            char* end;
+            const char digit[2] = {value[i], 0};
+            entry.keymap[i] = static_cast<uint8_t>(std::strtoul(digit, &end, 16));
+            if (*end != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (key == "reward")
+    {
+        const auto colon = value.find(':');
+        RewardAddress reward{static_cast<uint16_t>(std::strtoul(value.substr(0, colon).c_str(), nullptr, 16))};
+        if (colon != std::string::npos)
+        {
+            reward.scale = std::strtof(value.substr(colon + 1).c_str(), nullptr);
+        }
+        entry.rewards.push_back(reward);
+        return reward.address < chip8MemorySize && entry.rewards.size() <= maxRomRewards;
+    }
+    return false;
+}
+}  // namespace
+
+struct RomIndexRecord
+{
+    uint8_t sha1[20];
+    uint8_t quirks;
+    uint8_t rewardCount;
+    uint16_t hz;
+    uint8_t keymap[inputKeyCount];
+    RomIndexReward rewards[maxRomRewards];
+};
+
+static_assert(std::is_trivially_copyable_v<RomIndexRecord> && sizeof(RomIndexRecord) == 72);
+
+bool ReadRomDb(const std::string& path, std::vector<RomDbEntry>& entries)
+{
+    std::ifstream file{path};
+    if (!file)
+    {
+        return false;
+    }
+
+    std::string line;
+    for (int number = 1; std::getline(file, line); number++)
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields{line};
+
+        std::string sha1;
+        if (!(fields >> sha1))
+        {
+            continue;
+        }
+
+        RomDbEntry entry;
+        std::string profile;
+        bool valid = ParseSha1Hex(sha1, entry.sha1) && (fields >> profile) &&
+                     ParseQuirkProfile(profile, entry.quirks) && (fields >> entry.name);
+
+        std::string field;
+        while (valid && fields >> field)
+        {
+            valid = parseField(field, entry);
+        }
+
+        if (!valid)
+        {
+            std::cout << std::format("{}:{}: bad rom entry\n", path, number);
+            return false;
+        }
+        entries.push_back(entry);
+    }
+
+    return true;
+}
+
+namespace
+{
+std::vector<RomDbEntry> sortedUnique(std::vector<RomDbEntry> entries)
+{
+    // Stable sort keeps insertion order among equal keys, the last one wins
+    std::stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.sha1 < b.sha1; });
+    std::vector<RomDbEntry> unique;
+    for (auto& entry : entries)
+    {
+        if (!unique.empty() && unique.back().sha1 == entry.sha1)
+        {
+            unique.back() = std::move(entry);
+            continue;
+        }
+        unique.push_back(std::move(entry));
+    }
+    return unique;
+}
+}  // namespace
+
+bool WriteRomDb(const std::string& path, std::vector<RomDbEntry> entries)
+{
+    const RomDbEntry defaults;
+
+    std::ofstream file{path};
+    file << "# sha1 quirks name [hz=n] [keys=16 hex digits] [reward=address:scale]...\n";
+    for (const auto& entry : sortedUnique(std::move(entries)))
+    {
+        file << std::format("{} {} {}", Sha1Hex(entry.sha1), QuirkProfileName(entry.quirks), entry.name);
+        if (entry.hz != defaults.hz)
+        {
+            file << std::format(" hz={}", entry.hz);
+        }
+        if (entry.keymap != defaults.keymap)
+        {
+            file << " keys=";
+            for (const auto key : entry.keymap)
+            {
+                file << std::format("{:x}", key);
+            }
+        }
+        for (const auto& reward : entry.rewards)
+        {
+            file << std::format(" reward={:x}:{}", reward.address, reward.scale);
+        }
+        file << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+bool WriteRomIndex(const std::string& path, std::vector<RomDbEntry> entries)
+{
+    const auto unique = sortedUnique(std::move(entries));
+
+    RomIndexHeader header{};
+    std::memcpy(header.magic, indexMagic, sizeof(indexMagic));
+    header.version = indexVersion;
+    header.recordSize = sizeof(RomIndexRecord);
+    header.count = static_cast<uint32_t>(unique.size());
+
+    std::vector<RomIndexRecord> records(unique.size());
+    for (size_t i = 0; i < unique.size(); i++)
+    {
+        const auto& entry = unique[i];
+        auto& record = records[i];
+        record = {};
+        std::memcpy(record.sha1, entry.sha1.data(), sizeof(record.sha1));
+        record.quirks = static_cast<uint8_t>(entry.quirks);
+        record.hz = entry.hz;
+        std::memcpy(record.keymap, entry.keymap.data(), sizeof(record.keymap));
+        record.rewardCount = static_cast<uint8_t>(std::min<size_t>(entry.rewards.size(), maxRomRewards));
+        for (int r = 0; r < record.rewardCount; r++)
+        {
+            record.rewards[r] = {entry.rewards[r].address, 0, entry.rewards[r].scale};
+        }
+    }
+
+    std::ofstream file{path, std::ios::binary};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(RomIndexRecord));
+    return static_cast<bool>(file);
+}
+
+RomIndex::~RomIndex() { close(); }
+
+void RomIndex::close()
+{
+#if !defined(_WIN32)
+    if (mapping)
+    {
+        munmap(const_cast<void*>(mapping), mappingSize);
+    }
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    buffer.clear();
+    records = nullptr;
+    count = 0;
+}
+
+bool RomIndex::Open(const std::string& path)
+{
+    close();
+
+#if defined(_WIN32)
+    std::ifstream file{path, std::ios::binary};
+    if (!file)
+    {
+        return false;
+    }
+    buffer.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+    const uint8_t* data = buffer.data();
+    const size_t size = buffer.size();
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(RomIndexHeader)))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    mappingSize = static_cast<size_t>(info.st_size);
+    void* view = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED)
+    {
+        mappingSize = 0;
+        return false;
+    }
+    mapping = view;
+    const auto* data = static_cast<const uint8_t*>(mapping);
+    const size_t size = mappingSize;
+#endif
+
+    RomIndexHeader header;
+    if (size < sizeof(header))
+    {
+        close();
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    const bool valid = std::memcmp(header.magic, indexMagic, sizeof(indexMagic)) == 0 &&
+                       header.version == indexVersion && header.recordSize == sizeof(RomIndexRecord) &&
+                       header.count <= (size - sizeof(header)) / sizeof(RomIndexRecord);
+    if (!valid)
+    {
+        std::cout << std::format("Invalid rom index: {}\n", path);
+        close();
+        return false;
+    }
+
+    // The header is 16 bytes, records stay 4-byte aligned in the page-aligned mapping
+    records = reinterpret_cast<const RomIndexRecord*>(data + sizeof(header));
+    count = header.count;
+    return true;
+}
+
+bool RomIndex::Find(const Sha1Digest& sha1, RomDbEntry& entry) const
+{
+    const auto* end = records + count;
+    const auto* record = std::lower_bound(records, end, sha1,
+                                          [](const RomIndexRecord& record, const Sha1Digest& key)
+                                          { return std::memcmp(record.sha1, key.data(), key.size()) < 0; });
+    if (record == end || std::memcmp(record->sha1, sha1.data(), sha1.size()) != 0)
+    {
+        return false;
+    }
+
+    entry = {};
+    entry.sha1 = sha1;
+    entry.quirks = record->quirks < quirkProfileCount ? static_cast<QuirkProfile>(record->quirks)
+                                                      : QuirkProfile::Default;
+    entry.hz = record->hz;
+    std::memcpy(entry.keymap.data(), record->keymap, sizeof(record->keymap));
+    for (int r = 0; r < std::min<int>(record->rewardCount, maxRomRewards); r++)
+    {
+        entry.rewards.push_back({record->rewards[r].address, record->rewards[r].scale});
+    }
+    return true;
+}
+
+bool RomIndex::Find(const uint8_t* rom, size_t size, RomDbEntry& entry) const
+{
+    return Find(Sha1(rom, size), entry);
+}
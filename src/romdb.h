@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "chip8.h"
+#include "sha1.h"
+
+struct RewardAddress
+{
+    uint16_t address;
+    float scale = 1.0f;
+};
+
+// Instructions per second the frontends run at unless a ROM asks for another speed
+constexpr uint16_t defaultRomHz = cyclesPerFrame * 60;
+
+// Reward addresses kept per ROM in the binary index
+constexpr int maxRomRewards = 4;
+
+struct RomDbEntry
+{
+    Sha1Digest sha1{};
+    QuirkProfile quirks = QuirkProfile::Default;
+    uint16_t hz = defaultRomHz;
+    // keymap[n] = host key code (input.h) that drives CHIP-8 key n
+    std::array<uint8_t, inputKeyCount> keymap{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    std::vector<RewardAddress> rewards;
+    // File name the entry was created from, informational only and not in the index
+    std::string name;
+};
+
+// Text ROM database, one ROM per line:
+//   <sha1> <quirk profile> <name> [hz=<n>] [keys=<16 hex digits>] [reward=<hex address>:<scale>]...
+// '#' starts a comment and reward addresses are below 0x1000. Returns false if the file cannot be opened or a line
+// does not parse.
+[[nodiscard]] bool ReadRomDb(const std::string& path, std::vector<RomDbEntry>& entries);
+
+// Writes entries sorted by SHA-1, later duplicates replace earlier ones
+[[nodiscard]] bool WriteRomDb(const std::string& path, std::vector<RomDbEntry> entries);
+
+// Compiles entries into the binary index read by RomIndex: a header followed by fixed-size records sorted by SHA-1,
+// in native byte order
+[[nodiscard]] bool WriteRomIndex(const std::string& path, std::vector<RomDbEntry> entries);
+
+struct RomIndexRecord;
+
+// Read-only view of a binary ROM index. The file is memory-mapped, opening it costs no parsing and a lookup is a
+// binary search over the records.
+class RomIndex
+{
+public:
+    RomIndex() = default;
+    ~RomIndex();
+
+    RomIndex(const RomIndex&) = delete;
+    RomIndex& operator=(const RomIndex&) = delete;
+
+    [[nodiscard]] bool Open(const std::string& path);
+
+    // Fills everything but the name
+    [[nodiscard]] bool Find(const Sha1Digest& sha1, RomDbEntry& entry) const;
+    [[nodiscard]] bool Find(const uint8_t* rom, size_t size, RomDbEntry& entry) const;
+
+    [[nodiscard]] size_t Size() const { return count; }
+
+private:
+    void close();
+
+    // mmap'd file, or a copy of it where mmap is not available
+    const void* mapping = nullptr;
+    size_t mappingSize = 0;
+    std::vector<uint8_t> buffer;
+
+    const RomIndexRecord* records = nullptr;
+    size_t count = 0;
+};
@@ -0,0 +1,242 @@
+#include "scheduler.h"
+
+#include <algorithm>
+
+namespace
+{
+// Machines resumed per pool task
+constexpr size_t batchSize = 64;
+
+uint8_t byteAt(const Chip8& chip8, QuirkProfile profile, unsigned address)
+{
+    return QuirksOf(profile).xoChip ? chip8.MemoryAt<QuirkProfile::XoChip>(address)
+                                    : chip8.MemoryAt<QuirkProfile::Default>(address);
+}
+
+bool waitingForKey(const Chip8& chip8, QuirkProfile profile)
+{
+    return chip8.input == 0 && (chip8.NextOpcode(profile) & 0xf0ff) == 0xf00a;
+}
+
+// Instructions until a FX07; 3X00; 1NNN delay loop at pc falls through, 0 when pc is not on such a loop
+int delaySpinLength(const Chip8& chip8, QuirkProfile profile)
+{
+    const auto pc = chip8.pc;
+    if (pc > chip8.MemorySize(profile) - 6)
+    {
+        return 0;
+    }
+
+    uint8_t code[6];
+    for (int i = 0; i < 6; i++)
+    {
+        code[i] = byteAt(chip8, profile, pc + i);
+    }
+    const auto x = code[0] & 0xf;
+    const bool spin = (code[0] & 0xf0) == 0xf0 && code[1] == 0x07 && code[2] == (0x30 | x) && code[3] == 0 &&
+                      U8_CONCAT(code[4], code[5]) == (0x1000 | pc);
+    if (!spin)
+    {
+        return 0;
+    }
+
+    // Timers tick once per instruction, so every 3-instruction pass takes 3 off rdelay.
+    // The pass whose FX07 reads 0 skips over the jump.
+    const int passes = (chip8.rdelay + 2) / 3;
+    return 3 * passes + 2;
+}
+
+// Apply the result of running the delay loop at pc for `length` instructions
+void settleDelaySpin(Chip8& chip8, QuirkProfile profile, int length)
+{
+    chip8.regs[byteAt(chip8, profile, chip8.pc) & 0xf] = 0;
+    chip8.pc += 6;
+    chip8.rdelay = 0;
+    chip8.rsound = static_cast<uint8_t>(std::max(0, chip8.rsound - length));
+}
+}  // namespace
+
+struct Scheduler::NextFrame : std::suspend_always
+{
+};
+
+struct Scheduler::WaitForKey : std::suspend_always
+{
+    Scheduler& scheduler;
+    Slot& slot;
+    int cycle;
+
+    void await_suspend(std::coroutine_handle<>) const
+    {
+        slot.state = State::WaitingForKey;
+        slot.parkedFrame = scheduler.frame;
+        slot.parkedCycle = cycle;
+    }
+};
+
+struct Scheduler::Sleep : std::suspend_always
+{
+    Scheduler& scheduler;
+    Slot& slot;
+    uint64_t frames;
+
+    void await_suspend(std::coroutine_handle<>) const
+    {
+        slot.state = State::Sleeping;
+        slot.wakeFrame = scheduler.frame + frames;
+    }
+};
+
+MachineTask Scheduler::run(Scheduler& scheduler, Slot& slot)
+{
+    auto& chip8 = slot.chip8;
+    int cycle = 0;
+
+    while (true)
+    {
+        if (cycle == cyclesPerFrame)
+        {
+            co_await NextFrame{};
+            cycle = 0;
+            continue;
+        }
+
+        if (waitingForKey(chip8, slot.profile))
+        {
+            // Resumed at the start of the frame in which a key is down, FX0A then completes
+            co_await WaitForKey{{}, scheduler, slot, cycle};
+            cycle = 0;
+            continue;
+        }
+
+        if (const auto length = delaySpinLength(chip8, slot.profile))
+        {
+            settleDelaySpin(chip8, slot.profile, length);
+
+            const auto remaining = cyclesPerFrame - cycle;
+            if (length <= remaining)
+            {
+                cycle += length;
+                continue;
+            }
+
+            const auto overflow = length - remaining;
+            co_await Sleep{{}, scheduler, slot, 1 + static_cast<uint64_t>(overflow / cyclesPerFrame)};
+            cycle = overflow % cyclesPerFrame;
+            continue;
+        }
+
+        chip8.Run(slot.profile, 1);
+        cycle++;
+    }
+}
+
+Scheduler::Scheduler(unsigned threads) : pool(threads) {}
+
+Scheduler::~Scheduler()
+{
+    for (auto& slot : machines)
+    {
+        slot.handle.destroy();
+    }
+}
+
+size_t Scheduler::Add(const Chip8& initial, QuirkProfile profile)
+{
+    const auto id = machines.size();
+    auto& slot = machines.emplace_back(initial, profile);
+    if (initial.highMemory != nullptr)
+    {
+        slot.highMemory.assign(initial.highMemory, initial.highMemory + highMemorySize);
+        slot.chip8.highMemory = slot.highMemory.data();
+    }
+    slot.handle = run(*this, slot).handle;
+    active.push_back(id);
+    return id;
+}
+
+void Scheduler::SetKeys(size_t id, uint16_t keys)
+{
+    auto& slot = machines[id];
+    const bool wake = slot.state == State::WaitingForKey && keys && !slot.pendingKeys;
+    slot.pendingKeys = keys;
+    if (wake)
+    {
+        woken.push_back(id);
+    }
+}
+
+void Scheduler::RunFrame()
+{
+    while (!sleepers.empty() && sleepers.top().first <= frame)
+    {
+        const auto id = sleepers.top().second;
+        sleepers.pop();
+        machines[id].state = State::Running;
+        active.push_back(id);
+    }
+
+    for (const auto id : woken)
+    {
+        auto& slot = machines[id];
+        if (slot.state != State::WaitingForKey)
+        {
+            continue;
+        }
+
+        // FX0A would have spun, ticking both timers, for the rest of the parked frame and every frame since
+        const auto spins = static_cast<int64_t>(frame - slot.parkedFrame) * cyclesPerFrame - slot.parkedCycle;
+        slot.chip8.rdelay = static_cast<uint8_t>(std::max<int64_t>(0, slot.chip8.rdelay - spins));
+        slot.chip8.rsound = static_cast<uint8_t>(std::max<int64_t>(0, slot.chip8.rsound - spins));
+        slot.state = State::Running;
+        active.push_back(id);
+    }
+    woken.clear();
+
+    for (const auto id : active)
+    {
+        machines[id].chip8.input = machines[id].pendingKeys;
+    }
+
+    const auto batches = (active.size() + batchSize - 1) / batchSize;
+    pool.Run(batches,
+             [&](size_t batch, unsigned)
+             {
+                 const auto end = std::min(active.size(), (batch + 1) * batchSize);
+                 for (auto i = batch * batchSize; i < end; i++)
+                 {
+                     machines[active[i]].handle.resume();
+                 }
+             });
+
+    size_t keep = 0;
+    for (const auto id : active)
+    {
+        auto& slot = machines[id];
+        switch (slot.state)
+        {
+        case State::Running:
+        {
+            active[keep++] = id;
+            break;
+        }
+        case State::WaitingForKey:
+        {
+            // Keys set before this frame but after the machine last read its input
+            if (slot.pendingKeys)
+            {
+                woken.push_back(id);
+            }
+            break;
+        }
+        case State::Sleeping:
+        {
+            sleepers.emplace(slot.wakeFrame, id);
+            break;
+        }
+        }
+    }
+    active.resize(keep);
+
+    frame++;
+}
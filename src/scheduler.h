@@ -0,0 +1,101 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "chip8.h"
+#include "parallel.h"
+
+// Coroutine type of a machine's run loop
+struct MachineTask
+{
+    struct promise_type
+    {
+        MachineTask get_return_object() { return {std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Cooperative scheduler multiplexing many machines onto a small worker pool.
+//
+// Each machine runs as a coroutine that yields at frame boundaries. Machines blocked in FX0A are parked until
+// SetKeys presses a key, machines spinning on the delay timer (FX07; 3X00; 1NNN) are settled in closed form and
+// sleep for the frames the loop would have taken. Neither costs anything while waiting.
+class Scheduler
+{
+public:
+    explicit Scheduler(unsigned threads = 0);
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // Returns the machine id. The machine runs under profile; XO-CHIP high memory attached to initial is copied.
+    size_t Add(const Chip8& initial, QuirkProfile profile = QuirkProfile::Default);
+
+    // Keys take effect at the start of the next frame. Not safe to call during RunFrame.
+    void SetKeys(size_t id, uint16_t keys);
+
+    // Emulate one frame of every machine that is not waiting
+    void RunFrame();
+
+    [[nodiscard]] const Chip8& Machine(size_t id) const { return machines[id].chip8; }
+    [[nodiscard]] size_t Size() const { return machines.size(); }
+    [[nodiscard]] uint64_t Frame() const { return frame; }
+
+    // Parked on FX0A or sleeping through a delay loop. A sleeping machine has already been settled past the loop.
+    [[nodiscard]] bool Waiting(size_t id) const { return machines[id].state != State::Running; }
+
+    // Machines resumed during the last RunFrame
+    [[nodiscard]] size_t ActiveCount() const { return active.size(); }
+
+private:
+    enum class State : uint8_t
+    {
+        Running,
+        WaitingForKey,
+        Sleeping,
+    };
+
+    struct Slot
+    {
+        Chip8 chip8;
+        QuirkProfile profile = QuirkProfile::Default;
+        std::vector<uint8_t> highMemory;
+        std::coroutine_handle<> handle;
+        uint16_t pendingKeys = 0;
+        State state = State::Running;
+
+        // Where the machine stopped: frame, and instructions already run in that frame
+        uint64_t parkedFrame = 0;
+        int parkedCycle = 0;
+        uint64_t wakeFrame = 0;
+    };
+
+    struct NextFrame;
+    struct WaitForKey;
+    struct Sleep;
+
+    static MachineTask run(Scheduler& scheduler, Slot& slot);
+
+    std::deque<Slot> machines;
+    std::vector<size_t> active;
+    std::vector<size_t> woken;
+
+    using Wakeup = std::pair<uint64_t, size_t>;
+    std::priority_queue<Wakeup, std::vector<Wakeup>, std::greater<>> sleepers;
+
+    uint64_t frame = 0;
+    WorkerPool pool;
+};
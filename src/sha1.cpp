@@ -0,0 +1,147 @@
+#include "sha1.h"
+
+#include <bit>
+#include <format>
+
+namespace
+{
+void processBlock(uint32_t (&h)[5], const uint8_t* block)
+{
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++)
+    {
+        w[i] = (static_cast<uint32_t>(block[4 * i]) << 24) | (static_cast<uint32_t>(block[4 * i + 1]) << 16) |
+               (static_cast<uint32_t>(block[4 * i + 2]) << 8) | block[4 * i + 3];
+    }
+    for (int i = 16; i < 80; i++)
+    {
+        w[i] = std::rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++)
+    {
+        uint32_t f, k;
+        if (i < 20)
+        {
+            f = (b & c) | (~b & d);
+            k = 0x5a827999;
+        }
+        else if (i < 40)
+        {
+            f = b ^ c ^ d;
+            k = 0x6ed9eba1;
+        }
+        else if (i < 60)
+        {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8f1bbcdc;
+        }
+        else
+        {
+            f = b ^ c ^ d;
+            k = 0xca62c1d6;
+        }
+
+        const auto temp = std::rotl(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = std::rotl(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+}  // namespace
+
+Sha1Digest Sha1(const uint8_t* data, size_t size)
+{
+    uint32_t h[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+
+    size_t offset = 0;
+    for (; offset + 64 <= size; offset += 64)
+    {
+        processBlock(h, data + offset);
+    }
+
+    // Tail, 0x80 terminator and the bit length, spilling into a second block when it does not fit
+    uint8_t tail[128]{};
+    const auto remaining = size - offset;
+    for (size_t i = 0; i < remaining; i++)
+    {
+        tail[i] = data[offset + i];
+    }
+    tail[remaining] = 0x80;
+
+    const size_t tailSize = remaining < 56 ? 64 : 128;
+    const uint64_t bits = static_cast<uint64_t>(size) * 8;
+    for (int i = 0; i < 8; i++)
+    {
+        tail[tailSize - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+    }
+
+    processBlock(h, tail);
+    if (tailSize == 128)
+    {
+        processBlock(h, tail + 64);
+    }
+
+    Sha1Digest digest;
+    for (int i = 0; i < 20; i++)
+    {
+        digest[i] = static_cast<uint8_t>(h[i / 4] >> (24 - 8 * (i % 4)));
+    }
+    return digest;
+}
+
+std::string Sha1Hex(const Sha1Digest& digest)
+{
+    std::string hex;
+    for (const auto byte : digest)
+    {
+        hex += std::format("{:02x}", byte);
+    }
+    return hex;
+}
+
+bool ParseSha1Hex(const std::string& hex, Sha1Digest& digest)
+{
+    if (hex.size() != 2 * digest.size())
+    {
+        return false;
+    }
+
+    auto nibble = [](char c) -> int
+    {
+        if (c >= '0' && c <= '9')
+        {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f')
+        {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F')
+        {
+            return c - 'A' + 10;
+        }
+        return -1;
+    };
+
+    for (size_t i = 0; i < digest.size(); i++)
+    {
+        const auto hi = nibble(hex[2 * i]);
+        const auto lo = nibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0)
+        {
+            return false;
+        }
+        digest[i] = static_cast<uint8_t>(hi << 4 | lo);
+    }
+    return true;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using Sha1Digest = std::array<uint8_t, 20>;
+
+// SHA-1 of a ROM image, the key of the ROM database
+[[nodiscard]] Sha1Digest Sha1(const uint8_t* data, size_t size);
+
+[[nodiscard]] std::string Sha1Hex(const Sha1Digest& digest);
+[[nodiscard]] bool ParseSha1Hex(const std::string& hex, Sha1Digest& digest);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+
+// Set of state hashes shared between worker threads.
+// Lock striping keeps contention low: each hash only ever locks one of shardCount shards.
+class StateSet
+{
+public:
+    // Returns true if hash was not in the set yet
+    bool Insert(uint64_t hash)
+    {
+        auto& shard = shards[hash >> (64 - shardBits)];
+        std::lock_guard lock{shard.mutex};
+        if (!shard.hashes.insert(hash).second)
+        {
+            return false;
+        }
+        count.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    [[nodiscard]] size_t Size() const { return count.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int shardBits = 6;
+
+    struct alignas(64) Shard
+    {
+        std::mutex mutex;
+        std::unordered_set<uint64_t> hashes;
+    };
+
+    Shard shards[1 << shardBits];
+    std::atomic<size_t> count{0};
+};
@@ -0,0 +1,144 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <fstream>
+
+#include "opcode.h"
+
+namespace
+{
+constexpr char traceMagic[4] = {'C', '8', 'T', 'R'};
+constexpr uint32_t traceVersion = 1;
+
+struct TraceHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t recordSize;
+    // QuirkProfile, older files have 0 here and were all recorded with Default
+    uint8_t profile;
+    uint8_t reserved[3];
+    uint64_t firstCycle;
+    uint64_t count;
+};
+}  // namespace
+
+uint64_t TraceFile::Cycle(size_t index) const
+{
+    // Records are consecutive, so only the low bits need unwrapping
+    return firstCycle + static_cast<uint32_t>(records[index].cycle - static_cast<uint32_t>(firstCycle));
+}
+
+TraceRing::TraceRing(size_t capacity)
+    : mask(std::bit_ceil(std::max<size_t>(capacity, 1)) - 1), records(std::make_unique<TraceRecord[]>(mask + 1))
+{
+}
+
+void TraceRing::Run(Chip8& chip8, QuirkProfile profile, int count)
+{
+    auto run = [&]<QuirkProfile p>()
+    {
+        for (int i = 0; i < count; i++)
+        {
+            Step<p>(chip8);
+        }
+    };
+
+    switch (profile)
+    {
+    case QuirkProfile::Cosmac:
+        run.operator()<QuirkProfile::Cosmac>();
+        break;
+    case QuirkProfile::SuperChip:
+        run.operator()<QuirkProfile::SuperChip>();
+        break;
+    case QuirkProfile::XoChip:
+        run.operator()<QuirkProfile::XoChip>();
+        break;
+    default:
+        run.operator()<QuirkProfile::Default>();
+        break;
+    }
+}
+
+TraceFile TraceRing::Snapshot() const
+{
+    const auto end = head.load(std::memory_order_acquire);
+    const auto begin = end > Capacity() ? end - Capacity() : 0;
+
+    TraceFile trace;
+    trace.records.resize(end - begin);
+    for (auto cycle = begin; cycle < end; cycle++)
+    {
+        trace.records[cycle - begin] = records[cycle & mask];
+    }
+
+    // The writer may be filling the slot of cycle after - Capacity() right now, that one and everything older that
+    // was reused while we copied are dropped
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const auto after = head.load(std::memory_order_relaxed);
+    const auto first = std::min(end, after + 1 > Capacity() ? std::max(begin, after + 1 - Capacity()) : begin);
+    trace.records.erase(trace.records.begin(), trace.records.begin() + static_cast<ptrdiff_t>(first - begin));
+    trace.firstCycle = first;
+    trace.profile = lastProfile.load(std::memory_order_relaxed);
+    return trace;
+}
+
+bool TraceRing::Dump(const std::string& path) const { return WriteTrace(path, Snapshot()); }
+
+bool WriteTrace(const std::string& path, const TraceFile& trace)
+{
+    TraceHeader header{};
+    std::memcpy(header.magic, traceMagic, sizeof(traceMagic));
+    header.version = traceVersion;
+    header.recordSize = sizeof(TraceRecord);
+    header.profile = static_cast<uint8_t>(trace.profile);
+    header.firstCycle = trace.firstCycle;
+    header.count = trace.records.size();
+
+    std::ofstream file{path, std::ios::binary};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(trace.records.data()), trace.records.size() * sizeof(TraceRecord));
+    return static_cast<bool>(file);
+}
+
+bool ReadTrace(const std::string& path, TraceFile& trace)
+{
+    std::ifstream file{path, std::ios::binary};
+    TraceHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        return false;
+    }
+    if (std::memcmp(header.magic, traceMagic, sizeof(traceMagic)) != 0 || header.version != traceVersion ||
+        header.recordSize != sizeof(TraceRecord) || header.profile >= quirkProfileCount)
+    {
+        return false;
+    }
+
+    const auto start = file.tellg();
+    file.seekg(0, std::ios::end);
+    if (header.count > static_cast<uint64_t>(file.tellg() - start) / sizeof(TraceRecord))
+    {
+        return false;
+    }
+    file.seekg(start);
+
+    trace.firstCycle = header.firstCycle;
+    trace.profile = static_cast<QuirkProfile>(header.profile);
+    trace.records.resize(header.count);
+    return static_cast<bool>(
+        file.read(reinterpret_cast<char*>(trace.records.data()), trace.records.size() * sizeof(TraceRecord)));
+}
+
+std::string FormatTraceRecord(const TraceRecord& record, uint64_t cycle, QuirkProfile profile)
+{
+    const auto x = (record.opcode >> 8) & 0xf;
+    const auto y = (record.opcode >> 4) & 0xf;
+    return std::format("{:10}  {:03x}  {:04x}  {}  V{:X}={:02x} V{:X}={:02x} VF={:02x} I={:04x} sp={} keys={:04x}",
+                       cycle, record.pc, record.opcode, OpcodeClassName(ClassifyOpcode(record.opcode, profile)), x,
+                       record.vx, y, record.vy, record.vf, record.ri, record.sp, record.input);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "chip8.h"
+
+// One executed instruction. Registers are the values after it ran.
+struct TraceRecord
+{
+    // Low 32 bits of the instruction count, see TraceFile::firstCycle
+    uint32_t cycle;
+    uint16_t pc;
+    uint16_t opcode;
+    uint16_t ri;
+    uint16_t input;
+    // V[x] and V[y] of the opcode, whatever its form
+    uint8_t vx;
+    uint8_t vy;
+    uint8_t vf;
+    uint8_t sp;
+};
+
+static_assert(sizeof(TraceRecord) == 16, "TraceRecord is written to disk as is");
+
+// The last records of a ring, oldest first
+struct TraceFile
+{
+    uint64_t firstCycle = 0;
+    // Quirk profile the records ran under, their opcodes are read as it reads them
+    QuirkProfile profile = QuirkProfile::Default;
+    std::vector<TraceRecord> records;
+
+    // Full instruction count of records[index]
+    [[nodiscard]] uint64_t Cycle(size_t index) const;
+};
+
+// Fixed-size ring of the last executed instructions.
+//
+// Recording is a 16-byte store into preallocated memory and no syscalls, cheap enough to keep on in normal runs.
+// There is a single writer, the thread stepping the machine. Snapshot may be called from any other thread at the
+// same time: it rereads the write position after copying and drops the records overwritten meanwhile.
+class TraceRing
+{
+public:
+    // Capacity is rounded up to a power of two
+    explicit TraceRing(size_t capacity = 1 << 16);
+
+    template <QuirkProfile profile = QuirkProfile::Default>
+    void Step(Chip8& chip8)
+    {
+        const auto pc = chip8.pc;
+        const auto opcode = chip8.NextOpcode(profile);
+        chip8.ExecuteNext<profile>();
+        lastProfile.store(profile, std::memory_order_relaxed);
+
+        const auto cycle = head.load(std::memory_order_relaxed);
+        records[cycle & mask] = {static_cast<uint32_t>(cycle),
+                                 pc,
+                                 opcode,
+                                 chip8.ri,
+                                 chip8.input,
+                                 chip8.regs[(opcode >> 8) & 0xf],
+                                 chip8.regs[(opcode >> 4) & 0xf],
+                                 chip8.regs[0xf],
+                                 chip8.sp};
+        head.store(cycle + 1, std::memory_order_release);
+    }
+
+    // Traced counterpart of Chip8::Run
+    void Run(Chip8& chip8, QuirkProfile profile, int count);
+
+    // Instructions recorded since construction, including the ones already overwritten
+    [[nodiscard]] uint64_t Count() const { return head.load(std::memory_order_acquire); }
+    [[nodiscard]] size_t Capacity() const { return mask + 1; }
+
+    [[nodiscard]] TraceFile Snapshot() const;
+
+    // Binary dump of Snapshot(), read back with ReadTrace
+    [[nodiscard]] bool Dump(const std::string& path) const;
+
+private:
+    size_t mask;
+    std::unique_ptr<TraceRecord[]> records;
+    std::atomic<uint64_t> head = 0;
+    std::atomic<QuirkProfile> lastProfile = QuirkProfile::Default;
+};
+
+[[nodiscard]] bool WriteTrace(const std::string& path, const TraceFile& trace);
+[[nodiscard]] bool ReadTrace(const std::string& path, TraceFile& trace);
+
+// "  1234567  2a4  8124  8XY4  V1=05 V2=10 VF=01 I=0300 sp=1 keys=0000", the form as profile reads the opcode
+[[nodiscard]] std::string FormatTraceRecord(const TraceRecord& record, uint64_t cycle, QuirkProfile profile);
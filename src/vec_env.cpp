@@ -0,0 +1,121 @@
+#include "vec_env.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+uint32_t splitmix32(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return static_cast<uint32_t>(x ^ (x >> 31));
+}
+
+// Instances per pool task, keeps the shared index counter off the hot path
+constexpr size_t batchSize = 16;
+
+bool validConfig(const Chip8& initial, const VecEnvConfig& config)
+{
+    if (QuirksOf(config.quirks).xoChip && initial.highMemory != nullptr)
+    {
+        return false;
+    }
+
+    const auto outside = [](uint16_t address) { return address >= chip8MemorySize; };
+    return std::ranges::none_of(config.rewards, outside, &RewardAddress::address) &&
+           !(config.doneAddress && outside(*config.doneAddress));
+}
+}  // namespace
+
+VecEnv::VecEnv(const Chip8& initial, size_t count, VecEnvConfig config)
+    : initial(initial),
+      config(std::move(config)),
+      valid(validConfig(initial, this->config)),
+      fusion(this->config.fuse ? FusionTable{initial, this->config.quirks} : FusionTable{}),
+      machines(count, initial),
+      episodeFrames(count),
+      episodes(count),
+      rewards(count),
+      dones(count),
+      pool(std::make_unique<WorkerPool>(this->config.threads))
+{
+    // Instances are plain 4 KiB machines, profiles other than xochip never reach the snapshot's high memory
+    this->initial.highMemory = nullptr;
+    Reset();
+}
+
+void VecEnv::Reset()
+{
+    for (size_t i = 0; i < machines.size(); i++)
+    {
+        episodes[i] = 0;
+        resetInstance(i);
+        rewards[i] = 0;
+        dones[i] = 0;
+    }
+}
+
+bool VecEnv::Step(std::span<const uint16_t> actions)
+{
+    if (!valid || actions.size() < machines.size())
+    {
+        return false;
+    }
+
+    const auto batches = (machines.size() + batchSize - 1) / batchSize;
+    pool->Run(batches,
+              [&](size_t batch, unsigned)
+              {
+                  const auto end = std::min(machines.size(), (batch + 1) * batchSize);
+                  for (auto i = batch * batchSize; i < end; i++)
+                  {
+                      stepInstance(i, actions[i]);
+                  }
+              });
+    return true;
+}
+
+void VecEnv::resetInstance(size_t i)
+{
+    auto& chip8 = machines[i];
+    chip8 = initial;
+    if (config.reseed)
+    {
+        chip8.rng = splitmix32((static_cast<uint64_t>(i) << 32) | episodes[i]) | 1;
+    }
+    episodeFrames[i] = 0;
+    episodes[i]++;
+}
+
+void VecEnv::stepInstance(size_t i, uint16_t action)
+{
+    auto& chip8 = machines[i];
+
+    float before = 0;
+    for (const auto& reward : config.rewards)
+    {
+        before += reward.scale * chip8.memory[reward.address];
+    }
+
+    chip8.input = action;
+    fusion.Run(chip8, config.quirks, config.framesPerStep * cyclesPerFrame);
+    episodeFrames[i] += config.framesPerStep;
+
+    float after = 0;
+    for (const auto& reward : config.rewards)
+    {
+        after += reward.scale * chip8.memory[reward.address];
+    }
+    rewards[i] = after - before;
+
+    const bool finished = config.doneAddress && chip8.memory[*config.doneAddress] == config.doneValue;
+    const bool truncated = config.maxEpisodeFrames > 0 && episodeFrames[i] >= config.maxEpisodeFrames;
+    dones[i] = finished || truncated;
+
+    if (dones[i])
+    {
+        resetInstance(i);
+    }
+}
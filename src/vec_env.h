@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "chip8.h"
+#include "fusion.h"
+#include "parallel.h"
+#include "romdb.h"
+
+struct VecEnvConfig
+{
+    // Reward is the scaled change of the byte at each address over one step
+    std::vector<RewardAddress> rewards;
+
+    // Frames emulated per Step with the same action held
+    int framesPerStep = 1;
+
+    // Episodes are truncated after this many frames, 0 = unlimited
+    int maxEpisodeFrames = 0;
+
+    // Episode ends when memory[doneAddress] == doneValue
+    std::optional<uint16_t> doneAddress;
+    uint8_t doneValue = 0;
+
+    QuirkProfile quirks = QuirkProfile::Default;
+
+    // Give every instance and episode its own CXNN seed instead of the snapshot's
+    bool reseed = true;
+
+    // Run the initial program's instruction sequences as superinstructions, see FusionTable
+    bool fuse = false;
+
+    // Worker threads, 0 = every core
+    unsigned threads = 0;
+};
+
+// Batch of independent machines stepped together, for training agents headless.
+// Instances that finish an episode are reset from the shared initial snapshot during the same Step. Instances have no
+// XO-CHIP high memory, addresses past 4 KiB wrap as on the original machine.
+class VecEnv
+{
+public:
+    // Check Valid() before stepping
+    VecEnv(const Chip8& initial, size_t count, VecEnvConfig config);
+
+    // False if a reward or done address is past the 4 KiB of memory, or if config.quirks is xochip and initial has
+    // high memory the instances could not keep. Such an environment never steps.
+    [[nodiscard]] bool Valid() const { return valid; }
+
+    void Reset();
+
+    // actions[i] is the pressed-key mask (bit N = key N) for instance i. False without stepping anything if there are
+    // fewer actions than instances or the environment is not Valid().
+    [[nodiscard]] bool Step(std::span<const uint16_t> actions);
+
+    [[nodiscard]] size_t Size() const { return machines.size(); }
+    [[nodiscard]] std::span<const float> Rewards() const { return rewards; }
+    [[nodiscard]] std::span<const uint8_t> Dones() const { return dones; }
+
+    // Bit-packed first plane of instance i, one word per row in low resolution and two in high resolution (see
+    // Chip8::display). Points into the machine, valid until the next Step.
+    [[nodiscard]] std::span<const uint64_t, displayWords> Observation(size_t i) const
+    {
+        return machines[i].display[0];
+    }
+
+    [[nodiscard]] const Chip8& Machine(size_t i) const { return machines[i]; }
+
+private:
+    void resetInstance(size_t i);
+    void stepInstance(size_t i, uint16_t action);
+
+    Chip8 initial;
+    VecEnvConfig config;
+    bool valid;
+    // Empty unless config.fuse
+    FusionTable fusion;
+
+    std::vector<Chip8> machines;
+    std::vector<int> episodeFrames;
+    std::vector<uint32_t> episodes;
+    std::vector<float> rewards;
+    std::vector<uint8_t> dones;
+
+    std::unique_ptr<WorkerPool> pool;
+};
@@ -0,0 +1,419 @@
+// Headless throughput benchmark, prints JSON so results can be diffed across commits.
+//
+// Reports MIPS for every ROM, ns per instruction for synthetic single-opcode loops and for the loops FusionTable fuses,
+// the cost of presenting a frame and the memory used per machine.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "chip8.h"
+#include "lockstep.h"
+#include "fusion.h"
+#include "recompiled.h"
+#include "rom.h"
+
+#if defined(CHIP8_BENCH_BACKEND)
+#include "platform.h"
+#endif
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); }
+
+struct OpcodeLoop
+{
+    const char* name;
+    std::vector<uint16_t> setup;
+    uint16_t opcode;
+    QuirkProfile profile = QuirkProfile::Default;
+};
+
+// Fill the ROM area with setup followed by opcode repeated, then jump back to the start.
+// The setup and the jump are under 1% of the instructions executed. The XO-CHIP loops reach high memory.
+XoChip8 makeLoop(const OpcodeLoop& loop)
+{
+    XoChip8 machine{1};
+    auto& chip8 = machine.chip8;
+    uint16_t address = romStartAddress;
+    auto emit = [&](uint16_t opcode)
+    {
+        chip8.memory[address] = opcode >> 8;
+        chip8.memory[address + 1] = opcode & 0xff;
+        address += 2;
+    };
+
+    for (const auto opcode : loop.setup)
+    {
+        emit(opcode);
+    }
+
+    while (address < 0xe00)
+    {
+        if (loop.opcode == 0x1000)
+        {
+            // Jump chain, each jump lands on the next one
+            emit(0x1000 | (address + 2));
+        }
+        else if (loop.opcode == 0x2000)
+        {
+            // Call a subroutine that returns straight away
+            emit(0x2000 | 0xf00);
+        }
+        else
+        {
+            emit(loop.opcode);
+        }
+    }
+    emit(0x1000 | romStartAddress);
+
+    // 00EE for the call loop
+    chip8.memory[0xf00] = 0x00;
+    chip8.memory[0xf01] = 0xee;
+    chip8.pc = romStartAddress;
+    return machine;
+}
+
+const std::vector<OpcodeLoop> opcodeLoops = {
+    {"00E0", {}, 0x00e0},
+    {"1NNN", {}, 0x1000},
+    {"2NNN+00EE", {}, 0x2000},
+    {"3XNN", {}, 0x3001},
+    {"6XNN", {}, 0x6012},
+    {"7XNN", {}, 0x7001},
+    {"8XY4", {}, 0x8014},
+    {"8XY6", {}, 0x8016},
+    {"ANNN", {}, 0xa300},
+    {"CXNN", {}, 0xc0ff},
+    {"DXYN", {0xa050}, 0xd015},
+    {"EX9E", {}, 0xe09e},
+    {"FX07", {}, 0xf007},
+    {"FX1E", {}, 0xf01e},
+    {"FX33", {0xa300}, 0xf033},
+    {"FX55", {0xa300}, 0xff55},
+    {"FX65", {0xa300}, 0xff65},
+    // SUPER-CHIP 128x64, should cost what the low resolution forms do
+    {"DXYN hires", {0x00ff, 0xa050}, 0xd015, QuirkProfile::SuperChip},
+    {"DXY0 hires", {0x00ff, 0xa050}, 0xd010, QuirkProfile::SuperChip},
+    {"00CN hires", {0x00ff}, 0x00c1, QuirkProfile::SuperChip},
+    {"00FB hires", {0x00ff}, 0x00fb, QuirkProfile::SuperChip},
+    // XO-CHIP, both planes selected: each draw XORs two sprites into two bitboards
+    {"DXYN 2 planes", {0xf301, 0xa050}, 0xd015, QuirkProfile::XoChip},
+    {"FX55 high", {0xf000, 0x9000}, 0xff55, QuirkProfile::XoChip},
+};
+
+// Programs that spend nearly all their time in one loop FusionTable fuses, timed on the interpreter and fused
+struct FusedLoop
+{
+    const char* name;
+    std::vector<uint16_t> program;
+};
+
+const std::vector<FusedLoop> fusedLoops = {
+    {"spin", {0x1200}},
+    // Count V0 up to wrap around, then start over
+    {"counted loop", {0x6000, 0x7001, 0x3000, 0x1202, 0x1200}},
+    // Load the delay timer and wait for it to run out, then start over
+    {"delay wait", {0x60ff, 0xf015, 0xf007, 0x3000, 0x1204, 0x1200}},
+};
+
+std::vector<std::filesystem::path> defaultRoms()
+{
+    std::vector<std::filesystem::path> roms;
+    for (const auto* dir : {"rom", "tests"})
+    {
+        const auto path = std::filesystem::path{CHIP8_SOURCE_DIR} / dir;
+        if (!std::filesystem::is_directory(path))
+        {
+            continue;
+        }
+        for (const auto& entry : std::filesystem::directory_iterator{path})
+        {
+            if (entry.path().extension() == ".ch8")
+            {
+                roms.push_back(entry.path());
+            }
+        }
+    }
+    std::sort(roms.begin(), roms.end());
+    return roms;
+}
+
+std::string jsonNumber(double value) { return std::format("{:.3f}", value); }
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    uint64_t cycles = 10'000'000;
+    std::vector<std::filesystem::path> roms;
+    std::string outPath;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--cycles" && i + 1 < argc)
+        {
+            cycles = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--out" && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else
+        {
+            roms.emplace_back(arg);
+        }
+    }
+
+    if (roms.empty())
+    {
+        roms = defaultRoms();
+    }
+
+    // Results are folded into a checksum so nothing gets optimized away
+    uint64_t checksum = 0;
+
+    std::string romResults;
+    for (const auto& rom : roms)
+    {
+        RomImage image;
+        if (ReadRomFile(rom.string(), image) != RomError::None)
+        {
+            continue;
+        }
+
+        Chip8 chip8{1};
+        chip8.LoadRom(image.Bytes());
+
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < cycles; i++)
+        {
+            chip8.ExecuteNext();
+        }
+        const auto scalarSeconds = secondsSince(start);
+        checksum ^= chip8.Hash();
+
+        // Translations are checked against the interpreter's final state as well as timed
+        std::string recompiledResult;
+        if (const auto* program = FindRecompiled(image.sha1, QuirkProfile::Default))
+        {
+            Chip8 recompiled{1};
+            recompiled.LoadRom(image.Bytes());
+            start = Clock::now();
+            for (uint64_t done = 0; done < cycles;)
+            {
+                const auto count = static_cast<int>(std::min<uint64_t>(cycles - done, 1'000'000));
+                program->run(recompiled, count);
+                done += count;
+            }
+            const auto recompiledSeconds = secondsSince(start);
+            recompiledResult = std::format(", \"recompiled_mips\": {}, \"recompiled_matches\": {}",
+                                           jsonNumber(cycles / recompiledSeconds / 1e6),
+                                           recompiled.Hash() == chip8.Hash() ? "true" : "false");
+        }
+
+        // Superinstructions run in frame-sized slices, as the frontend runs them
+        Chip8 fused{1};
+        fused.LoadRom(image.Bytes());
+        const FusionTable fusion{fused, QuirkProfile::Default};
+        start = Clock::now();
+        for (uint64_t done = 0; done < cycles;)
+        {
+            const auto count = static_cast<int>(std::min<uint64_t>(cycles - done, cyclesPerFrame));
+            fusion.Run(fused, QuirkProfile::Default, count);
+            done += count;
+        }
+        const auto fusedSeconds = secondsSince(start);
+
+        // Same ROM in every lane with different seeds
+        auto lockstep = std::make_unique<LockstepChip8>();
+        for (int lane = 0; lane < lockstepLanes; lane++)
+        {
+            Chip8 seeded{static_cast<uint32_t>(lane + 1)};
+            seeded.LoadRom(image.Bytes());
+            lockstep->Store(lane, seeded);
+        }
+        const auto lockstepSteps = std::max<uint64_t>(1, cycles / lockstepLanes);
+        start = Clock::now();
+        for (uint64_t i = 0; i < lockstepSteps; i++)
+        {
+            lockstep->ExecuteNext();
+        }
+        const auto lockstepSeconds = secondsSince(start);
+        checksum ^= lockstep->Load(0).Hash();
+
+        // Every lane is checked against the same machine run on its own
+        bool lockstepMatches = true;
+        for (int lane = 0; lane < lockstepLanes; lane++)
+        {
+            Chip8 reference{static_cast<uint32_t>(lane + 1)};
+            reference.LoadRom(image.Bytes());
+            for (uint64_t done = 0; done < lockstepSteps;)
+            {
+                const auto count = static_cast<int>(std::min<uint64_t>(lockstepSteps - done, 1'000'000));
+                reference.Run(QuirkProfile::Default, count);
+                done += count;
+            }
+            lockstepMatches &= lockstep->Load(lane).Hash() == reference.Hash();
+        }
+
+        romResults += std::format("{}    {{\"rom\": \"{}\", \"mips\": {}, \"ns_per_instruction\": {}, "
+                                  "\"lockstep_mips\": {}, \"lockstep_matches\": {}, \"fused_sites\": {}, "
+                                  "\"fused_mips\": {}, \"fused_matches\": {}{}}}",
+                                  romResults.empty() ? "" : ",\n", rom.filename().string(),
+                                  jsonNumber(cycles / scalarSeconds / 1e6), jsonNumber(scalarSeconds * 1e9 / cycles),
+                                  jsonNumber(lockstepSteps * lockstepLanes / lockstepSeconds / 1e6),
+                                  lockstepMatches ? "true" : "false", fusion.Size(),
+                                  jsonNumber(cycles / fusedSeconds / 1e6),
+                                  fused.Hash() == chip8.Hash() ? "true" : "false", recompiledResult);
+    }
+
+    std::string opcodeResults;
+    for (const auto& loop : opcodeLoops)
+    {
+        auto machine = makeLoop(loop);
+        auto& chip8 = machine.chip8;
+        const auto start = Clock::now();
+        for (uint64_t done = 0; done < cycles;)
+        {
+            const auto count = static_cast<int>(std::min<uint64_t>(cycles - done, 1'000'000));
+            chip8.Run(loop.profile, count);
+            done += count;
+        }
+        const auto seconds = secondsSince(start);
+        checksum ^= chip8.Hash();
+
+        opcodeResults += std::format("{}    \"{}\": {}", opcodeResults.empty() ? "" : ",\n", loop.name,
+                                     jsonNumber(seconds * 1e9 / cycles));
+    }
+
+    // Both sides in frame-sized slices, as the frontend runs them
+    std::string fusedLoopResults;
+    for (const auto& loop : fusedLoops)
+    {
+        Chip8 plain{1};
+        for (size_t i = 0; i < loop.program.size(); i++)
+        {
+            plain.memory[romStartAddress + i * 2] = loop.program[i] >> 8;
+            plain.memory[romStartAddress + i * 2 + 1] = loop.program[i] & 0xff;
+        }
+        plain.pc = romStartAddress;
+        auto fused = plain;
+        const FusionTable fusion{fused, QuirkProfile::Default};
+
+        auto start = Clock::now();
+        for (uint64_t done = 0; done < cycles; done += cyclesPerFrame)
+        {
+            plain.Run(QuirkProfile::Default, cyclesPerFrame);
+        }
+        const auto plainSeconds = secondsSince(start);
+
+        start = Clock::now();
+        for (uint64_t done = 0; done < cycles; done += cyclesPerFrame)
+        {
+            fusion.Run(fused, QuirkProfile::Default, cyclesPerFrame);
+        }
+        const auto fusedSeconds = secondsSince(start);
+        checksum ^= fused.Hash();
+
+        fusedLoopResults += std::format(
+            "{}    \"{}\": {{\"ns_interpreted\": {}, \"ns_fused\": {}, \"matches\": {}}}",
+            fusedLoopResults.empty() ? "" : ",\n", loop.name, jsonNumber(plainSeconds * 1e9 / cycles),
+            jsonNumber(fusedSeconds * 1e9 / cycles), fused.Hash() == plain.Hash() ? "true" : "false");
+    }
+
+    // Snapshot and hash cost, what the explorer and the environments pay per state
+    Chip8 chip8{1};
+    constexpr int stateIterations = 100'000;
+    auto start = Clock::now();
+    for (int i = 0; i < stateIterations; i++)
+    {
+        Chip8 copy = chip8;
+        copy.regs[0] = static_cast<uint8_t>(i);
+        checksum ^= copy.regs[i & 0xf];
+    }
+    const auto snapshotNs = secondsSince(start) * 1e9 / stateIterations;
+
+    start = Clock::now();
+    for (int i = 0; i < stateIterations; i++)
+    {
+        chip8.regs[0] = static_cast<uint8_t>(i);
+        checksum ^= chip8.Hash();
+    }
+    const auto hashNs = secondsSince(start) * 1e9 / stateIterations;
+
+    // Frame presentation: expanding the display is shared by every backend
+    constexpr int presentFrames = 2000;
+    auto gameMachine = makeLoop(*std::find_if(opcodeLoops.begin(), opcodeLoops.end(),
+                                              [](const auto& loop) { return std::string{loop.name} == "DXYN"; }));
+    auto& game = gameMachine.chip8;
+    for (int i = 0; i < cyclesPerFrame * 100; i++)
+    {
+        game.ExecuteNext();
+    }
+    uint32_t videoBuffer[hiresWidth * hiresHeight];
+    start = Clock::now();
+    for (int i = 0; i < presentFrames; i++)
+    {
+        game.display[0][0] ^= i;
+        game.RenderVideo(videoBuffer);
+        checksum ^= videoBuffer[i % (chip8Width * chip8Height)];
+    }
+    const auto renderNs = secondsSince(start) * 1e9 / presentFrames;
+
+    std::string backendResult = "null";
+#if defined(CHIP8_BENCH_BACKEND)
+    if (platform_create_offscreen(800, 600))
+    {
+        start = Clock::now();
+        for (int i = 0; i < presentFrames; i++)
+        {
+            game.display[0][0] ^= i;
+            game.RenderVideo(videoBuffer);
+            if (!platform_update_window(videoBuffer, game.DisplayWidth(), game.DisplayHeight()))
+            {
+                break;
+            }
+        }
+        backendResult = jsonNumber(secondsSince(start) * 1e9 / presentFrames);
+        platform_close_window();
+    }
+    const std::string backendName = CHIP8_BENCH_BACKEND;
+#else
+    const std::string backendName = "none";
+#endif
+
+    std::string json = "{\n";
+    json += std::format("  \"cycles\": {},\n", cycles);
+    json += std::format("  \"roms\": [\n{}\n  ],\n", romResults);
+    json += std::format("  \"ns_per_opcode\": {{\n{}\n  }},\n", opcodeResults);
+    json += std::format("  \"fused_loops\": {{\n{}\n  }},\n", fusedLoopResults);
+    json += std::format("  \"snapshot_ns\": {},\n", jsonNumber(snapshotNs));
+    json += std::format("  \"hash_ns\": {},\n", jsonNumber(hashNs));
+    json += std::format("  \"present_ns\": {{\"render_video\": {}, \"backend\": \"{}\", \"backend_present\": {}}},\n",
+                        jsonNumber(renderNs), backendName, backendResult);
+    json += std::format("  \"bytes_per_instance\": {{\"chip8\": {}, \"lockstep_lane\": {}}},\n", sizeof(Chip8),
+                        sizeof(LockstepChip8) / lockstepLanes);
+    json += std::format("  \"checksum\": \"{:016x}\"\n", checksum);
+    json += "}\n";
+
+    // Backends log to stdout, --out keeps the JSON clean
+    if (outPath.empty())
+    {
+        std::cout << json;
+        return 0;
+    }
+
+    std::ofstream out{outPath};
+    out << json;
+    return out ? 0 : 1;
+}
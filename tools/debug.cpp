@@ -0,0 +1,308 @@
+// Interactive debugger on stdin.
+//
+//   chip8_debug <rom> [--quirks profile]
+//
+// Commands (addresses in hex, an empty line repeats the last command):
+//   b <addr> / bd <addr>       set / delete a breakpoint
+//   w <addr> / wd <addr>       watch / unwatch a memory byte
+//   wr <reg> / wrd <reg>       watch / unwatch V0..VF or I
+//   s [n]                      step n instructions
+//   n                          step, running a 2NNN until it returns
+//   c [frames]                 continue until a breakpoint or watchpoint, at most frames frames
+//   keys <mask>                set the pressed keys, bit N = key N
+//   r                          registers, stack and timers
+//   x <addr> [len]             memory dump
+//   l [addr] [count]           disassembly, around pc by default
+//   screen                     print the display
+//   info                       list breakpoints and watchpoints
+//   q                          quit
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+
+#include "chip8.h"
+#include "debugger.h"
+#include "disasm.h"
+#include "rom.h"
+
+namespace
+{
+// An hour of emulated time, the bound of a plain "c"
+constexpr int defaultContinueFrames = 60 * 60 * 60;
+
+std::optional<uint16_t> parseAddress(const std::string& text)
+{
+    if (text.empty())
+    {
+        return std::nullopt;
+    }
+    char* end = nullptr;
+    const auto value = std::strtoul(text.c_str(), &end, 16);
+    if (*end != '\0' || value >= xoMemorySize)
+    {
+        return std::nullopt;
+    }
+    return static_cast<uint16_t>(value);
+}
+
+// "V0".."VF" or "I"
+std::optional<int> parseRegister(const std::string& text)
+{
+    if (text == "I" || text == "i")
+    {
+        return watchRegisterI;
+    }
+    if (text.size() == 2 && (text[0] == 'V' || text[0] == 'v') && std::isxdigit(static_cast<unsigned char>(text[1])))
+    {
+        return std::stoi(text.substr(1), nullptr, 16);
+    }
+    return std::nullopt;
+}
+
+std::string registerName(int index) { return index == watchRegisterI ? "I" : std::format("V{:X}", index); }
+
+// Byte at address in the memory profile reaches, which wraps at its end
+uint8_t byteAt(const Chip8& chip8, unsigned address, QuirkProfile profile)
+{
+    return chip8.MemoryAt<QuirkProfile::XoChip>(address % chip8.MemorySize(profile));
+}
+
+std::string instructionLine(const Chip8& chip8, uint16_t address, const Debugger& debugger, QuirkProfile profile)
+{
+    address %= chip8.MemorySize(profile);
+    const auto opcode = U8_CONCAT(byteAt(chip8, address, profile), byteAt(chip8, address + 1, profile));
+    const auto marker = address == chip8.pc % chip8.MemorySize(profile) ? "=>" : "  ";
+    const auto breakpoint = debugger.HasBreakpoint(address) ? '*' : ' ';
+    return std::format("{}{}{:03x}: {:04x}  {}", marker, breakpoint, address, opcode, Disassemble(opcode, profile));
+}
+
+void printStop(const DebugStop& stop, const Chip8& chip8, const Debugger& debugger, QuirkProfile profile)
+{
+    switch (stop.reason)
+    {
+    case StopReason::Breakpoint:
+        std::cout << std::format("Breakpoint at 0x{:03x} after {} instructions\n", chip8.pc & 0xfff, stop.executed);
+        break;
+    case StopReason::Watchpoint:
+    {
+        const auto name = stop.registerWatch ? registerName(stop.location) : std::format("[0x{:03x}]", stop.location);
+        std::cout << std::format("Watchpoint {}: 0x{:x} -> 0x{:x} after {} instructions\n", name, stop.before,
+                                 stop.after, stop.executed);
+        break;
+    }
+    case StopReason::None:
+        std::cout << std::format("Ran {} instructions\n", stop.executed);
+        break;
+    default:
+        break;
+    }
+    std::cout << instructionLine(chip8, chip8.pc, debugger, profile) << '\n';
+}
+
+void printRegisters(const Chip8& chip8)
+{
+    for (int i = 0; i < 16; i++)
+    {
+        std::cout << std::format("V{:X}={:02x}{}", i, chip8.regs[i], i % 8 == 7 ? "\n" : " ");
+    }
+    std::cout << std::format("PC={:03x} I={:03x} DT={:02x} ST={:02x} SP={} keys={:04x}\n", chip8.pc, chip8.ri,
+                             chip8.rdelay, chip8.rsound, chip8.sp, chip8.input);
+    std::cout << "stack:";
+    for (int i = 0; i < chip8.sp && i < stackSize; i++)
+    {
+        std::cout << std::format(" {:03x}", chip8.stack[i]);
+    }
+    std::cout << '\n';
+}
+
+void printMemory(const Chip8& chip8, uint16_t address, int length, QuirkProfile profile)
+{
+    for (int offset = 0; offset < length; offset += 16)
+    {
+        std::cout << std::format("{:03x}:", (address + offset) % chip8.MemorySize(profile));
+        for (int i = offset; i < std::min(length, offset + 16); i++)
+        {
+            std::cout << std::format(" {:02x}", byteAt(chip8, address + i, profile));
+        }
+        std::cout << '\n';
+    }
+}
+
+void printScreen(const Chip8& chip8)
+{
+    for (int y = 0; y < chip8.DisplayHeight(); y++)
+    {
+        const auto* first = chip8.DisplayRow(y, 0);
+        const auto* second = chip8.DisplayRow(y, 1);
+        std::string line;
+        for (int x = 0; x < chip8.DisplayWidth(); x++)
+        {
+            // Lit planes, the second one only used by XO-CHIP
+            const auto lit = READ_BIT(first[x / 64], 63 - x % 64) | READ_BIT(second[x / 64], 63 - x % 64) << 1;
+            line += ".#o@"[lit];
+        }
+        std::cout << line << '\n';
+    }
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    QuirkProfile quirks = QuirkProfile::Default;
+    const bool validQuirks = argc == 4 && std::string{argv[2]} == "--quirks" && ParseQuirkProfile(argv[3], quirks);
+    if (argc != 2 && !validQuirks)
+    {
+        std::cout << "Usage: chip8_debug <rom> [--quirks profile]\n";
+        return 1;
+    }
+
+    RomImage rom;
+    if (const auto error = ReadRomFile(argv[1], rom, quirks); error != RomError::None)
+    {
+        std::cout << std::format("Failed to load rom {}: {}\n", argv[1], RomErrorMessage(error));
+        return 1;
+    }
+
+    XoChip8 machine{1};
+    auto& chip8 = machine.chip8;
+    chip8.LoadRom(rom.Bytes(), quirks);
+    Debugger debugger;
+
+    std::cout << instructionLine(chip8, chip8.pc, debugger, quirks) << '\n';
+
+    std::string line;
+    std::string lastLine;
+    while (std::cout << "(chip8) " << std::flush, std::getline(std::cin, line))
+    {
+        if (line.empty())
+        {
+            line = lastLine;
+        }
+        lastLine = line;
+
+        std::istringstream words{line};
+        std::string command;
+        std::string first;
+        std::string second;
+        words >> command >> first >> second;
+
+        if (command.empty())
+        {
+            continue;
+        }
+        else if (command == "q")
+        {
+            break;
+        }
+        else if ((command == "b" || command == "bd" || command == "w" || command == "wd") && parseAddress(first))
+        {
+            const auto address = *parseAddress(first);
+            if (address >= chip8.MemorySize(quirks) && (command == "b" || command == "w"))
+            {
+                std::cout << std::format("0x{:x} is past the {} profile's memory\n", address, QuirkProfileName(quirks));
+            }
+            else if (command == "b")
+            {
+                debugger.SetBreakpoint(address);
+            }
+            else if (command == "bd")
+            {
+                debugger.ClearBreakpoint(address);
+            }
+            else if (command == "w")
+            {
+                debugger.WatchMemory(address);
+            }
+            else
+            {
+                debugger.UnwatchMemory(address);
+            }
+        }
+        else if ((command == "wr" || command == "wrd") && parseRegister(first))
+        {
+            if (command == "wr")
+            {
+                debugger.WatchRegister(*parseRegister(first));
+            }
+            else
+            {
+                debugger.UnwatchRegister(*parseRegister(first));
+            }
+        }
+        else if (command == "s")
+        {
+            const int count = first.empty() ? 1 : std::max(1, std::atoi(first.c_str()));
+            DebugStop stop{StopReason::Step};
+            for (int i = 0; i < count && stop.reason == StopReason::Step; i++)
+            {
+                stop = debugger.Step(chip8, quirks);
+            }
+            printStop(stop, chip8, debugger, quirks);
+        }
+        else if (command == "n")
+        {
+            const auto stop = debugger.StepOver(chip8, quirks, defaultContinueFrames * cyclesPerFrame);
+            printStop(stop, chip8, debugger, quirks);
+        }
+        else if (command == "c")
+        {
+            const int frames = first.empty() ? defaultContinueFrames : std::max(1, std::atoi(first.c_str()));
+            printStop(debugger.Run(chip8, quirks, frames * cyclesPerFrame), chip8, debugger, quirks);
+        }
+        else if (command == "keys" && !first.empty())
+        {
+            chip8.input = static_cast<uint16_t>(std::strtoul(first.c_str(), nullptr, 16));
+        }
+        else if (command == "r")
+        {
+            printRegisters(chip8);
+        }
+        else if (command == "x" && parseAddress(first))
+        {
+            printMemory(chip8, *parseAddress(first), second.empty() ? 64 : std::atoi(second.c_str()), quirks);
+        }
+        else if (command == "l")
+        {
+            const auto around = static_cast<uint16_t>(chip8.pc - 8);
+            const auto start = first.empty() ? around : parseAddress(first).value_or(around);
+            const int count = second.empty() ? 10 : std::atoi(second.c_str());
+            for (int i = 0; i < count; i++)
+            {
+                std::cout << instructionLine(chip8, static_cast<uint16_t>(start + 2 * i), debugger, quirks) << '\n';
+            }
+        }
+        else if (command == "screen")
+        {
+            printScreen(chip8);
+        }
+        else if (command == "info")
+        {
+            for (const auto address : debugger.Breakpoints())
+            {
+                std::cout << std::format("breakpoint 0x{:03x}\n", address);
+            }
+            for (const auto address : debugger.MemoryWatches())
+            {
+                std::cout << std::format("watch [0x{:03x}]\n", address);
+            }
+            for (int index = 0; index <= watchRegisterI; index++)
+            {
+                if (debugger.RegisterWatches()[index])
+                {
+                    std::cout << std::format("watch {}\n", registerName(index));
+                }
+            }
+        }
+        else
+        {
+            std::cout << std::format("Unknown command: {}\n", line);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,254 @@
+// Differential runner: steps the current core and the 2022 core in lockstep on the same ROM and input, and reports
+// the first point where their architectural state differs.
+//
+// Default mode compares registers, I, timers, stack, memory and framebuffer after every instruction. --fast only
+// compares a state hash per frame and replays the diverging frame instruction by instruction to locate the cause.
+//
+// CXNN draws from different random generators, so its result is copied from the 2022 core. The 2022 core draws from
+// std::rand, which is reseeded at the start of every frame so a frame replays with the same numbers.
+
+#include <algorithm>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "chip8.h"
+#include "rom.h"
+#include "v1_oracle.h"
+
+namespace
+{
+struct KeyEvent
+{
+    int frame;
+    uint16_t keys;
+};
+
+struct Options
+{
+    std::string romPath;
+    int frames = 600;
+    bool fast = false;
+    std::vector<KeyEvent> script;
+};
+
+struct Pair
+{
+    Chip8 current;
+    v1::Chip8 oracle;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+
+    options.romPath = argv[1];
+    for (int i = 2; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--fast")
+        {
+            options.fast = true;
+        }
+        else if (arg == "--frames" && i + 1 < argc)
+        {
+            options.frames = std::atoi(argv[++i]);
+        }
+        else if (arg == "--keys" && i + 1 < argc)
+        {
+            // <frame>:<hex key mask>
+            const std::string event = argv[++i];
+            const auto colon = event.find(':');
+            if (colon == std::string::npos)
+            {
+                return false;
+            }
+            const auto keys = static_cast<uint16_t>(std::strtoul(event.substr(colon + 1).c_str(), nullptr, 16));
+            options.script.push_back({std::atoi(event.substr(0, colon).c_str()), keys});
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Only the state both cores have: no input, CXNN seed or stale stack slots
+Chip8 comparable(const Chip8& chip8)
+{
+    Chip8 out = chip8;
+    out.input = 0;
+    out.rng = 0;
+    for (int i = out.sp; i < stackSize; i++)
+    {
+        out.stack[i] = 0;
+    }
+    return out;
+}
+
+Chip8 exportOracle(const v1::Chip8& oracle)
+{
+    Chip8 out{1};
+    v1::Chip8Oracle::Export(oracle, out);
+    return comparable(out);
+}
+
+std::vector<std::string> differences(const Chip8& current, const Chip8& oracle)
+{
+    std::vector<std::string> out;
+    auto field = [&](const std::string& name, int a, int b)
+    {
+        if (a != b)
+        {
+            out.push_back(std::format("{}: current 0x{:x}, v1 0x{:x}", name, a, b));
+        }
+    };
+
+    for (int i = 0; i < 16; i++)
+    {
+        field(std::format("V{:X}", i), current.regs[i], oracle.regs[i]);
+    }
+    field("pc", current.pc, oracle.pc);
+    field("I", current.ri, oracle.ri);
+    field("delay", current.rdelay, oracle.rdelay);
+    field("sound", current.rsound, oracle.rsound);
+    field("stack depth", current.sp, oracle.sp);
+    for (int i = 0; i < std::min<int>(current.sp, stackSize); i++)
+    {
+        field(std::format("stack[{}]", i), current.stack[i], oracle.stack[i]);
+    }
+
+    for (int address = 0; address < chip8MemorySize; address++)
+    {
+        field(std::format("memory[0x{:03x}]", address), current.memory[address], oracle.memory[address]);
+    }
+
+    for (int y = 0; y < chip8Height; y++)
+    {
+        if (current.display[0][y] != oracle.display[0][y])
+        {
+            out.push_back(std::format("display row {}: current {:016x}, v1 {:016x}", y, current.display[0][y],
+                                      oracle.display[0][y]));
+        }
+    }
+    return out;
+}
+
+uint16_t fetch(const Chip8& chip8)
+{
+    return U8_CONCAT(chip8.memory[chip8.pc & 0xfff], chip8.memory[(chip8.pc + 1) & 0xfff]);
+}
+
+void stepPair(Pair& pair)
+{
+    const auto opcode = fetch(pair.current);
+    pair.current.ExecuteNext();
+    pair.oracle.ExecuteCycle();
+
+    if ((opcode >> 12) == 0xc)
+    {
+        const auto x = (opcode >> 8) & 0xf;
+        pair.current.regs[x] = v1::Chip8Oracle::Register(pair.oracle, x);
+    }
+}
+
+// v1's CXNN reads the global std::rand state, which a replay of the frame has to start from as well
+void seedFrame(int frame) { std::srand(static_cast<unsigned>(frame) + 1); }
+
+// Steps one frame comparing after every instruction, returns false at the first divergence
+bool runFrameChecked(Pair& pair, int frame)
+{
+    seedFrame(frame);
+    for (int cycle = 0; cycle < cyclesPerFrame; cycle++)
+    {
+        const auto pc = pair.current.pc;
+        const auto opcode = fetch(pair.current);
+        stepPair(pair);
+
+        const auto diffs = differences(comparable(pair.current), exportOracle(pair.oracle));
+        if (!diffs.empty())
+        {
+            std::cout << std::format("Divergence in frame {}, cycle {}, after pc 0x{:03x} opcode 0x{:04x}\n", frame,
+                                     cycle, pc, opcode);
+            for (const auto& diff : diffs)
+            {
+                std::cout << "  " << diff << "\n";
+            }
+            return false;
+        }
+    }
+    return true;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cout << "Usage: chip8_diff <rom> [--frames n] [--fast] [--keys frame:hexmask ...]\n";
+        return 1;
+    }
+
+    RomImage rom;
+    if (const auto error = ReadRomFile(options.romPath, rom); error != RomError::None)
+    {
+        std::cout << std::format("Failed to load rom {}: {}\n", options.romPath, RomErrorMessage(error));
+        return 1;
+    }
+
+    v1::Keyboard keyboard;
+    Pair pair{Chip8{1}, v1::Chip8{&keyboard}};
+    v1::Chip8Oracle::Reset(pair.oracle);
+    pair.oracle.LoadRom(reinterpret_cast<const char*>(rom.bytes.data()), static_cast<int>(rom.bytes.size()));
+    pair.current.LoadRom(rom.Bytes());
+
+    size_t nextEvent = 0;
+    for (int frame = 0; frame < options.frames; frame++)
+    {
+        while (nextEvent < options.script.size() && options.script[nextEvent].frame <= frame)
+        {
+            pair.current.input = options.script[nextEvent++].keys;
+        }
+        for (int key = 0; key < inputKeyCount; key++)
+        {
+            pair.current.KeyDown(key) ? keyboard.KeyDown(key) : keyboard.KeyUp(key);
+        }
+
+        if (!options.fast)
+        {
+            if (!runFrameChecked(pair, frame))
+            {
+                return 1;
+            }
+            continue;
+        }
+
+        const auto snapshot = pair;
+        seedFrame(frame);
+        for (int cycle = 0; cycle < cyclesPerFrame; cycle++)
+        {
+            stepPair(pair);
+        }
+
+        if (comparable(pair.current).Hash() != exportOracle(pair.oracle).Hash())
+        {
+            // Replay the frame instruction by instruction to find where it went wrong
+            auto replay = snapshot;
+            if (runFrameChecked(replay, frame))
+            {
+                std::cout << std::format("Hash differs after frame {} but the replay did not reproduce it\n", frame);
+            }
+            return 1;
+        }
+    }
+
+    std::cout << std::format("No divergence in {} frames\n", options.frames);
+    return 0;
+}
@@ -0,0 +1,203 @@
+// Static disassembler: follows control flow from 0x200 to separate code from data and prints annotated disassembly.
+//
+//   chip8_dis <rom> [--dot file] [--quirks profile]
+//
+// Blocks are labelled start, sub_XXX (call targets) or loc_XXX, data read through ANNN is labelled data_XXX and
+// printed one byte per line with its pixels. Problems the interpreter would only hit at run time are listed first.
+// --dot writes the control flow graph for Graphviz, calls as dashed edges. Opcodes are read as the quirk profile,
+// default unless given, reads them.
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "analysis.h"
+#include "disasm.h"
+#include "rom.h"
+
+namespace
+{
+std::string labelOf(const ProgramAnalysis& analysis, uint16_t address)
+{
+    if (address == romStartAddress)
+    {
+        return "start";
+    }
+    if (analysis.callTargets[address])
+    {
+        return std::format("sub_{:03x}", address);
+    }
+    if (analysis.blocks.contains(address))
+    {
+        return std::format("loc_{:03x}", address);
+    }
+    if (analysis.dataReferences[address])
+    {
+        return std::format("data_{:03x}", address);
+    }
+    return {};
+}
+
+std::string operandComment(const ProgramAnalysis& analysis, uint16_t opcode, QuirkProfile profile)
+{
+    switch (ClassifyOpcode(opcode, profile))
+    {
+    case OpcodeClass::Jump:
+    case OpcodeClass::Call:
+    case OpcodeClass::LoadI:
+    {
+        const auto label = labelOf(analysis, opcode & 0xfff);
+        return label.empty() ? std::string{} : "; " + label;
+    }
+    default:
+        return {};
+    }
+}
+
+std::string pixels(uint8_t byte)
+{
+    std::string line;
+    for (int bit = 7; bit >= 0; bit--)
+    {
+        line += READ_BIT(byte, bit) ? '#' : '.';
+    }
+    return line;
+}
+
+void writeDot(std::ostream& out, const Chip8& chip8, const ProgramAnalysis& analysis, QuirkProfile profile)
+{
+    out << "digraph cfg {\n    node [shape=box fontname=monospace];\n";
+    for (const auto& [start, block] : analysis.blocks)
+    {
+        std::string text = labelOf(analysis, start) + "\\l";
+        for (auto address = start; address < block.end;)
+        {
+            const auto opcode = U8_CONCAT(chip8.memory[address], chip8.memory[(address + 1) & 0xfff]);
+            text += std::format("{:03x}: {}\\l", address, Disassemble(opcode, profile));
+            address += InstructionLength(opcode, profile);
+        }
+        out << std::format("    \"{:03x}\" [label=\"{}\"];\n", start, text);
+        for (size_t i = 0; i < block.successors.size(); i++)
+        {
+            const bool call = block.exit == OpcodeClass::Call && i == 0;
+            out << std::format("    \"{:03x}\" -> \"{:03x}\"{};\n", start, block.successors[i],
+                               call ? " [style=dashed]" : "");
+        }
+    }
+    out << "}\n";
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    std::optional<std::string> dotPath;
+    QuirkProfile profile = QuirkProfile::Default;
+    bool valid = argc >= 2;
+    for (int i = 2; valid && i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--dot" && i + 1 < argc)
+        {
+            dotPath = argv[++i];
+        }
+        else
+        {
+            valid = arg == "--quirks" && i + 1 < argc && ParseQuirkProfile(argv[++i], profile);
+        }
+    }
+    if (!valid)
+    {
+        std::cout << "Usage: chip8_dis <rom> [--dot file] [--quirks profile]\n";
+        return 1;
+    }
+
+    RomImage rom;
+    if (const auto error = ReadRomFile(argv[1], rom, profile); error != RomError::None)
+    {
+        std::cout << std::format("Failed to load rom {}: {}\n", argv[1], RomErrorMessage(error));
+        return 1;
+    }
+    XoChip8 machine;
+    auto& chip8 = machine.chip8;
+    chip8.LoadRom(rom.Bytes(), profile);
+    const auto analysis = AnalyzeProgram(chip8, profile);
+    // The analysis stops at 4 KiB, the rest of an XO-CHIP image is not listed
+    const auto romEnd = static_cast<uint16_t>(std::min<size_t>(romStartAddress + rom.Bytes().size(), chip8MemorySize));
+
+    std::map<uint16_t, std::vector<uint16_t>> predecessors;
+    for (const auto& [start, block] : analysis.blocks)
+    {
+        for (const auto successor : block.successors)
+        {
+            predecessors[successor].push_back(block.end - (block.exit == OpcodeClass::LoadILong ? 4 : 2));
+        }
+    }
+
+    int codeBytes = 0;
+    for (uint16_t address = romStartAddress; address < romEnd; address++)
+    {
+        codeBytes += analysis.IsCode(address);
+    }
+    std::cout << std::format("; {}: {} bytes, {} blocks, {} code bytes, {} data bytes\n", argv[1],
+                             romEnd - romStartAddress, analysis.blocks.size(), codeBytes,
+                             romEnd - romStartAddress - codeBytes);
+    for (const auto& issue : analysis.issues)
+    {
+        std::cout << std::format("; warning 0x{:03x}: {} ({:04x})\n", issue.address, issue.message, issue.opcode);
+    }
+
+    // Code reached past the end of the ROM image is still listed
+    const auto end = std::max<int>(romEnd, analysis.blocks.empty() ? 0 : analysis.blocks.rbegin()->second.end);
+    for (int address = romStartAddress; address < end;)
+    {
+        const auto location = static_cast<uint16_t>(address);
+        if (const auto label = labelOf(analysis, location); !label.empty())
+        {
+            std::string from;
+            for (const auto predecessor : predecessors[location])
+            {
+                from += std::format("{}{:03x}", from.empty() ? "; from " : ", ", predecessor);
+            }
+            std::cout << (from.empty() ? label + ":" : std::format("{:40}{}", label + ":", from)) << '\n';
+        }
+
+        if (analysis.code[location])
+        {
+            const auto opcode = U8_CONCAT(chip8.memory[location], chip8.memory[(location + 1) & 0xfff]);
+            auto text = std::format("    {:03x}: {:04x}  {}", location, opcode, Disassemble(opcode, profile));
+            if (InstructionLength(opcode, profile) == 4)
+            {
+                const auto target =
+                    U8_CONCAT(chip8.memory[(location + 2) & 0xfff], chip8.memory[(location + 3) & 0xfff]);
+                text = std::format("    {:03x}: {:04x}  LD I, 0x{:04x}", location, opcode, target);
+            }
+            const auto comment = operandComment(analysis, opcode, profile);
+            std::cout << (comment.empty() ? text : std::format("{:40}{}", text, comment)) << '\n';
+            address += InstructionLength(opcode, profile);
+        }
+        else
+        {
+            const auto text = std::format("    {:03x}: {:02x}    DB 0x{:02x}", location, chip8.memory[location],
+                                          chip8.memory[location]);
+            std::cout << std::format("{:40}; {}\n", text, pixels(chip8.memory[location]));
+            address++;
+        }
+    }
+
+    if (dotPath)
+    {
+        std::ofstream out(*dotPath);
+        writeDot(out, chip8, analysis, profile);
+        if (!out)
+        {
+            std::cout << std::format("Failed to write {}\n", *dotPath);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,233 @@
+// Checks the ways of running machines other than the plain interpreter against it.
+//
+// Every ROM in tests/ runs under every quirk profile with a key script, once with Chip8::Run and once through each
+// runner. The Scheduler's machines are compared by Hash() after every frame they are not waiting, two small programs
+// make it park on FX0A and settle a FX07 delay loop. VecEnv instances, plain and fused, get their own key scripts and
+// are compared after every step, across an episode reset. Configs VecEnv has to reject are checked as well.
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "chip8.h"
+#include "rom.h"
+#include "scheduler.h"
+#include "vec_env.h"
+
+namespace
+{
+constexpr int frames = 300;
+
+struct Program
+{
+    std::string name;
+    std::vector<uint8_t> image;
+};
+
+std::vector<uint8_t> assemble(const std::vector<uint16_t>& opcodes)
+{
+    std::vector<uint8_t> image;
+    for (const auto opcode : opcodes)
+    {
+        image.push_back(opcode >> 8);
+        image.push_back(opcode & 0xff);
+    }
+    return image;
+}
+
+std::vector<Program> programs(const std::filesystem::path& testsDir)
+{
+    std::vector<Program> result = {
+        // Start the delay timer, wait for a key, count the presses and go back to waiting
+        {"fx0a wait", assemble({0x6140, 0xf115, 0xf00a, 0x7201, 0x1204})},
+        // Wait on the delay timer, beep and count the rounds, with the wait spanning several frames
+        {"fx07 spin", assemble({0x603c, 0xf015, 0xf018, 0xf007, 0x3000, 0x1206, 0x7101, 0x1200})},
+    };
+
+    std::vector<std::filesystem::path> roms;
+    for (const auto& entry : std::filesystem::directory_iterator{testsDir})
+    {
+        if (entry.path().extension() == ".ch8")
+        {
+            roms.push_back(entry.path());
+        }
+    }
+    std::sort(roms.begin(), roms.end());
+
+    for (const auto& rom : roms)
+    {
+        RomImage image;
+        if (ReadRomFile(rom.string(), image) == RomError::None)
+        {
+            result.push_back({rom.filename().string(), {image.Bytes().begin(), image.Bytes().end()}});
+        }
+    }
+    return result;
+}
+
+// Hold each key in turn for a while, with nothing pressed in between
+uint16_t keysAt(int frame) { return (frame / 20) % 2 ? static_cast<uint16_t>(1u << (frame / 40 % inputKeyCount)) : 0; }
+
+// Empty when every frame the scheduler ran matches
+std::string checkScheduler(const Program& program, QuirkProfile profile)
+{
+    XoChip8 plain{1};
+    if (plain.chip8.LoadRom(program.image, profile) != RomError::None)
+    {
+        return {};
+    }
+
+    Scheduler scheduler{1};
+    const auto id = scheduler.Add(plain.chip8, profile);
+    int waited = 0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        plain.chip8.input = keysAt(frame);
+        plain.chip8.Run(profile, cyclesPerFrame);
+        scheduler.SetKeys(id, keysAt(frame));
+        scheduler.RunFrame();
+
+        if (scheduler.Waiting(id))
+        {
+            waited++;
+        }
+        else if (scheduler.Machine(id).Hash() != plain.chip8.Hash())
+        {
+            return std::format("scheduler differs after frame {}", frame);
+        }
+    }
+
+    if (program.name.starts_with("fx") && waited == 0)
+    {
+        return "scheduler never waited";
+    }
+    return {};
+}
+
+// Empty when every instance matches its plain run after every step
+std::string checkVecEnv(const Program& program, QuirkProfile profile, bool fuse)
+{
+    Chip8 initial{1};
+    if (initial.LoadRom(program.image, profile) != RomError::None)
+    {
+        return {};
+    }
+
+    constexpr size_t instances = 4;
+    VecEnvConfig config;
+    config.quirks = profile;
+    config.reseed = false;
+    config.fuse = fuse;
+    // Truncates each episode once mid-run
+    config.maxEpisodeFrames = frames / 2 + 1;
+    config.threads = 1;
+    VecEnv env{initial, instances, config};
+    if (!env.Valid())
+    {
+        return "VecEnv rejected its config";
+    }
+
+    std::vector<Chip8> plain(instances, initial);
+    std::vector<uint16_t> actions(instances);
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (size_t i = 0; i < instances; i++)
+        {
+            actions[i] = keysAt(frame + static_cast<int>(i) * 20);
+        }
+        if (!env.Step(actions))
+        {
+            return "VecEnv did not step";
+        }
+
+        for (size_t i = 0; i < instances; i++)
+        {
+            plain[i].input = actions[i];
+            plain[i].Run(profile, cyclesPerFrame);
+            if ((frame + 1) % config.maxEpisodeFrames == 0)
+            {
+                plain[i] = initial;
+            }
+            if (env.Machine(i).Hash() != plain[i].Hash())
+            {
+                return std::format("{}VecEnv instance {} differs after frame {}", fuse ? "fused " : "", i, frame);
+            }
+        }
+    }
+    return {};
+}
+
+// Empty when VecEnv refuses configs it cannot honour
+std::string checkVecEnvRejects()
+{
+    const XoChip8 xo{1};
+    VecEnvConfig xoConfig;
+    xoConfig.quirks = QuirkProfile::XoChip;
+    if (VecEnv{xo.chip8, 1, xoConfig}.Valid())
+    {
+        return "VecEnv accepted an xochip snapshot with high memory";
+    }
+
+    const Chip8 chip8{1};
+    VecEnvConfig rewardConfig;
+    rewardConfig.rewards.push_back({chip8MemorySize});
+    VecEnvConfig doneConfig;
+    doneConfig.doneAddress = chip8MemorySize;
+    for (const auto& config : {rewardConfig, doneConfig})
+    {
+        VecEnv env{chip8, 1, config};
+        const uint16_t action = 0;
+        if (env.Valid() || env.Step({&action, 1}))
+        {
+            return "VecEnv accepted an address past 4 KiB";
+        }
+    }
+    return {};
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    std::filesystem::path testsDir = std::filesystem::path{CHIP8_SOURCE_DIR} / "tests";
+    if (argc == 3 && std::string{argv[1]} == "--tests")
+    {
+        testsDir = argv[2];
+    }
+    else if (argc != 1)
+    {
+        std::cout << "Usage: chip8_equivalence [--tests dir]\n";
+        return 1;
+    }
+
+    int checks = 1;
+    int failures = 0;
+    if (const auto message = checkVecEnvRejects(); !message.empty())
+    {
+        std::cout << std::format("FAIL {}\n", message);
+        failures++;
+    }
+
+    for (const auto& program : programs(testsDir))
+    {
+        for (const auto profile : {QuirkProfile::Default, QuirkProfile::Cosmac, QuirkProfile::SuperChip,
+                                   QuirkProfile::XoChip})
+        {
+            for (const auto& message : {checkScheduler(program, profile), checkVecEnv(program, profile, false),
+                                        checkVecEnv(program, profile, true)})
+            {
+                checks++;
+                if (!message.empty())
+                {
+                    std::cout << std::format("FAIL {} {}: {}\n", program.name, QuirkProfileName(profile), message);
+                    failures++;
+                }
+            }
+        }
+    }
+
+    std::cout << std::format("{}/{} passed\n", checks - failures, checks);
+    return failures ? 1 : 0;
+}
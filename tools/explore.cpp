@@ -0,0 +1,212 @@
+// Breadth-first exploration of the states a ROM can reach.
+//
+// Every frame each frontier state branches into one child per key choice (no key, or a single key held).
+// Children are deduplicated by Chip8::Hash() and the frontier is spread across all cores.
+
+#include <bitset>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "chip8.h"
+#include "parallel.h"
+#include "state_set.h"
+
+namespace
+{
+struct Options
+{
+    std::string romPath;
+    int depth = 60;
+    size_t maxStates = 100000;
+    unsigned threads = 0;
+    uint32_t seed = 1;
+    // Key choices explored each frame, 0 = no key pressed
+    std::vector<uint16_t> choices;
+};
+
+void printUsage()
+{
+    std::cout << "Usage: chip8_explore <rom> [--depth frames] [--max-states n] [--threads n] [--seed n] "
+                 "[--keys 0123456789abcdef]\n";
+}
+
+// atoi, refusing negative values
+bool parseCount(const std::string& arg, const char* value, int& count)
+{
+    count = std::atoi(value);
+    if (count < 0)
+    {
+        std::cout << std::format("{} must not be negative\n", arg);
+        return false;
+    }
+    return true;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+
+    options.romPath = argv[1];
+    std::string keys = "0123456789abcdef";
+
+    for (int i = 2; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cout << std::format("Missing value for {}\n", arg);
+            return false;
+        }
+
+        const char* value = argv[++i];
+        if (arg == "--depth")
+        {
+            if (!parseCount(arg, value, options.depth))
+            {
+                return false;
+            }
+        }
+        else if (arg == "--max-states")
+        {
+            options.maxStates = std::strtoull(value, nullptr, 10);
+        }
+        else if (arg == "--threads")
+        {
+            int threads;
+            if (!parseCount(arg, value, threads))
+            {
+                return false;
+            }
+            options.threads = threads;
+        }
+        else if (arg == "--seed")
+        {
+            options.seed = std::strtoul(value, nullptr, 10);
+        }
+        else if (arg == "--keys")
+        {
+            keys = value;
+        }
+        else
+        {
+            std::cout << std::format("Unknown option {}\n", arg);
+            return false;
+        }
+    }
+
+    options.choices.push_back(0);
+    for (const auto c : keys)
+    {
+        if (!std::isxdigit(static_cast<unsigned char>(c)))
+        {
+            std::cout << std::format("Not a key: {}\n", c);
+            return false;
+        }
+        const auto key = std::stoi(std::string{c}, nullptr, 16);
+        options.choices.push_back(1 << key);
+    }
+
+    return true;
+}
+
+struct Worker
+{
+    std::vector<Chip8> next;
+    std::bitset<4096> coverage;
+    size_t framesRun = 0;
+};
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    Chip8 root{options.seed};
+    if (const auto error = root.LoadRom(options.romPath); error != RomError::None)
+    {
+        std::cout << std::format("Failed to load rom {}: {}\n", options.romPath, RomErrorMessage(error));
+        return 1;
+    }
+
+    const auto threads = options.threads ? options.threads : DefaultThreadCount();
+    std::vector<Worker> workers(threads);
+
+    StateSet visited;
+    visited.Insert(root.Hash());
+
+    std::vector<Chip8> frontier{root};
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int depth = 1; depth <= options.depth && !frontier.empty(); depth++)
+    {
+        ParallelFor(frontier.size(), threads,
+                    [&](size_t index, unsigned worker)
+                    {
+                        auto& local = workers[worker];
+                        for (const auto keys : options.choices)
+                        {
+                            if (visited.Size() >= options.maxStates)
+                            {
+                                return;
+                            }
+
+                            Chip8 child = frontier[index];
+                            child.input = keys;
+                            for (int i = 0; i < cyclesPerFrame; i++)
+                            {
+                                local.coverage.set(child.pc & 0xfff);
+                                child.ExecuteNext();
+                            }
+                            local.framesRun++;
+
+                            if (visited.Insert(child.Hash()))
+                            {
+                                local.next.push_back(child);
+                            }
+                        }
+                    });
+
+        frontier.clear();
+        for (auto& worker : workers)
+        {
+            frontier.insert(frontier.end(), worker.next.begin(), worker.next.end());
+            worker.next.clear();
+        }
+
+        std::cout << std::format("depth {:3} frontier {:8} visited {:8}\n", depth, frontier.size(), visited.Size());
+
+        if (visited.Size() >= options.maxStates)
+        {
+            std::cout << "State limit reached\n";
+            break;
+        }
+    }
+
+    // Levels cut short by the state limit step fewer frames than frontier x choices
+    std::bitset<4096> coverage;
+    size_t framesRun = 0;
+    for (const auto& worker : workers)
+    {
+        coverage |= worker.coverage;
+        framesRun += worker.framesRun;
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << std::format("{} states, {} instruction addresses covered, {} frames in {:.3f}s ({:.0f} frames/s)\n",
+                             visited.Size(), coverage.count(), framesRun, elapsed.count(),
+                             framesRun / elapsed.count());
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Fuzz target for the instruction core.
+//
+// Input layout: <quirk profile> <rom size, 2 bytes little endian> <rom> <key mask per frame, 2 bytes each>. The
+// profile byte is taken modulo the profile count, the ROM is clamped to what is left of the input and to what the
+// profile can load, frames past the end of the key stream keep the last mask. Every input runs for a bounded number
+// of frames from a power-on snapshot that is restored by copy, nothing is constructed per run.
+//
+// With CHIP8_FUZZ on, libFuzzer (or AFL++ through its libFuzzer driver) provides main. Otherwise this builds a
+// replay driver that runs every file given on the command line, for reproducing crashes under the sanitizers.
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "chip8.h"
+
+namespace
+{
+constexpr int maxFrames = 256;
+
+const XoChip8 powerOn{1};
+XoChip8 machine{1};
+
+void run(const uint8_t* data, size_t size)
+{
+    if (size < 3)
+    {
+        return;
+    }
+
+    const auto profile = static_cast<QuirkProfile>(data[0] % quirkProfileCount);
+    const size_t romSize = std::min<size_t>(
+        {static_cast<size_t>(U8_CONCAT(data[2], data[1])), size - 3, static_cast<size_t>(MaxRomSize(profile))});
+    const auto* keys = data + 3 + romSize;
+    const auto keyCount = (size - 3 - romSize) / 2;
+
+    machine = powerOn;
+    auto& chip8 = machine.chip8;
+    if (chip8.LoadRom({data + 3, romSize}, profile) != RomError::None)
+    {
+        return;
+    }
+
+    for (int frame = 0; frame < maxFrames; frame++)
+    {
+        if (static_cast<size_t>(frame) < keyCount)
+        {
+            chip8.input = static_cast<uint16_t>(U8_CONCAT(keys[2 * frame + 1], keys[2 * frame]));
+        }
+
+        chip8.Run(profile, cyclesPerFrame);
+    }
+
+    // Keep the result observable
+    volatile auto hash = chip8.Hash();
+    (void)hash;
+}
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    run(data, size);
+    return 0;
+}
+
+#if !defined(CHIP8_LIBFUZZER)
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: chip8_fuzz <input>...\n";
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::ifstream file{argv[i], std::ios::binary};
+        if (!file)
+        {
+            std::cout << std::format("Failed to open input: {}\n", argv[i]);
+            return 1;
+        }
+
+        const std::vector<uint8_t> input{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+        run(input.data(), input.size());
+    }
+
+    std::cout << std::format("Ran {} inputs\n", argc - 1);
+    return 0;
+}
+#endif
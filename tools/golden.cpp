@@ -0,0 +1,275 @@
+// Golden-frame regression harness.
+//
+// Runs every ROM listed in tests/golden/manifest.txt headless under its quirk profile for a fixed number of frames,
+// with scripted input, and compares the final framebuffer against the checked-in image tests/golden/<rom>.pbm. XO-CHIP
+// cases also compare the second plane against tests/golden/<rom>.plane1.pbm. ROMs run in parallel.
+//
+// Manifest lines: <rom> <quirk profile> <frames> [<frame>:<hex key mask> ...], '#' starts a comment.
+
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "chip8.h"
+#include "parallel.h"
+#include "rom.h"
+
+namespace
+{
+struct KeyEvent
+{
+    int frame;
+    uint16_t keys;
+};
+
+struct GoldenCase
+{
+    std::string rom;
+    QuirkProfile quirks = QuirkProfile::Default;
+    int frames = 0;
+    std::vector<KeyEvent> script;
+
+    // Filled in by the run
+    bool passed = false;
+    std::string message;
+};
+
+bool parseManifest(const std::filesystem::path& path, std::vector<GoldenCase>& cases)
+{
+    std::ifstream manifest{path};
+    if (!manifest)
+    {
+        std::cout << std::format("Failed to open manifest: {}\n", path.string());
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(manifest, line))
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields{line};
+
+        GoldenCase golden;
+        std::string quirks;
+        if (!(fields >> golden.rom >> quirks >> golden.frames))
+        {
+            continue;
+        }
+        if (!ParseQuirkProfile(quirks, golden.quirks))
+        {
+            std::cout << std::format("Unknown quirk profile '{}' for {}\n", quirks, golden.rom);
+            return false;
+        }
+
+        std::string event;
+        while (fields >> event)
+        {
+            const auto colon = event.find(':');
+            if (colon == std::string::npos)
+            {
+                std::cout << std::format("Bad key event '{}' for {}\n", event, golden.rom);
+                return false;
+            }
+            const auto keys = static_cast<uint16_t>(std::strtoul(event.substr(colon + 1).c_str(), nullptr, 16));
+            golden.script.push_back({std::atoi(event.substr(0, colon).c_str()), keys});
+        }
+        cases.push_back(golden);
+    }
+
+    return true;
+}
+
+uint64_t displayHash(const Chip8& chip8, int plane)
+{
+    // FNV-1a over the rows
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (int y = 0; y < chip8.DisplayHeight(); y++)
+    {
+        for (int word = 0; word < chip8.DisplayWidth() / 64; word++)
+        {
+            h = (h ^ chip8.DisplayRow(y, plane)[word]) * 0x100000001b3ull;
+        }
+    }
+    return h;
+}
+
+// Plain PBM (P1), one character per pixel so diffs of the golden files stay readable
+void writePbm(const std::filesystem::path& path, const Chip8& chip8, int plane)
+{
+    std::ofstream out{path};
+    out << std::format("P1\n# hash {:016x}\n{} {}\n", displayHash(chip8, plane), chip8.DisplayWidth(),
+                       chip8.DisplayHeight());
+    for (int y = 0; y < chip8.DisplayHeight(); y++)
+    {
+        const auto* row = chip8.DisplayRow(y, plane);
+        for (int x = 0; x < chip8.DisplayWidth(); x++)
+        {
+            out << (READ_BIT(row[x / 64], 63 - x % 64) ? '1' : '0');
+        }
+        out << '\n';
+    }
+}
+
+// Into plane of the display of frame, 64x32 or 128x64
+bool readPbm(const std::filesystem::path& path, Chip8& frame, int plane)
+{
+    std::ifstream in{path};
+    std::string magic;
+    if (!(in >> magic) || magic != "P1")
+    {
+        return false;
+    }
+
+    int width = 0;
+    int height = 0;
+    while (in >> std::ws && in.peek() == '#')
+    {
+        std::string comment;
+        std::getline(in, comment);
+    }
+    if (!(in >> width >> height))
+    {
+        return false;
+    }
+    if (width == hiresWidth && height == hiresHeight)
+    {
+        frame.SetHires(true);
+    }
+    else if (width != chip8Width || height != chip8Height)
+    {
+        return false;
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        auto* row = &frame.display[plane][y * (width / 64)];
+        for (int x = 0; x < width; x++)
+        {
+            char pixel;
+            if (!(in >> pixel))
+            {
+                return false;
+            }
+            row[x / 64] |= static_cast<uint64_t>(pixel == '1') << (63 - x % 64);
+        }
+    }
+    return true;
+}
+
+XoChip8 runCase(const RomImage* rom, const GoldenCase& golden)
+{
+    XoChip8 machine{1};
+    auto& chip8 = machine.chip8;
+    const bool loaded = rom && chip8.LoadRom(rom->Bytes(), golden.quirks) == RomError::None;
+
+    size_t nextEvent = 0;
+    for (int frame = 0; loaded && frame < golden.frames; frame++)
+    {
+        while (nextEvent < golden.script.size() && golden.script[nextEvent].frame <= frame)
+        {
+            chip8.input = golden.script[nextEvent++].keys;
+        }
+
+        chip8.Run(golden.quirks, cyclesPerFrame);
+    }
+
+    return machine;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    std::filesystem::path testsDir = std::filesystem::path{CHIP8_SOURCE_DIR} / "tests";
+    bool update = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--update")
+        {
+            update = true;
+        }
+        else if (arg == "--tests" && i + 1 < argc)
+        {
+            testsDir = argv[++i];
+        }
+        else
+        {
+            std::cout << "Usage: chip8_golden [--tests dir] [--update]\n";
+            return 1;
+        }
+    }
+
+    const auto goldenDir = testsDir / "golden";
+    std::vector<GoldenCase> cases;
+    if (!parseManifest(goldenDir / "manifest.txt", cases))
+    {
+        return 1;
+    }
+
+    // Several cases may run the same ROM with different scripts
+    RomCache roms;
+    ParallelFor(cases.size(), 0,
+                [&](size_t index, unsigned)
+                {
+                    auto& golden = cases[index];
+                    RomError error;
+                    const auto rom = roms.Load((testsDir / golden.rom).string(), error, golden.quirks);
+                    if (!rom)
+                    {
+                        golden.message = RomErrorMessage(error);
+                        return;
+                    }
+                    const auto machine = runCase(rom.get(), golden);
+                    const auto& chip8 = machine.chip8;
+
+                    // Only XO-CHIP draws into the planes past the first
+                    const auto planes = QuirksOf(golden.quirks).xoChip ? planeCount : 1;
+                    golden.passed = true;
+                    for (int plane = 0; plane < planes && golden.passed; plane++)
+                    {
+                        const auto suffix = plane ? std::format(".plane{}.pbm", plane) : std::string{".pbm"};
+                        const auto imagePath = goldenDir / std::filesystem::path{golden.rom}.replace_extension(suffix);
+                        if (update)
+                        {
+                            writePbm(imagePath, chip8, plane);
+                            golden.message = "updated";
+                            continue;
+                        }
+
+                        Chip8 expected{1};
+                        if (!readPbm(imagePath, expected, plane))
+                        {
+                            golden.passed = false;
+                            golden.message = std::format("missing or invalid golden image {}", imagePath.string());
+                            break;
+                        }
+
+                        golden.passed =
+                            expected.hires == chip8.hires && displayHash(expected, plane) == displayHash(chip8, plane);
+                        if (!golden.passed)
+                        {
+                            auto actualPath = imagePath;
+                            actualPath.replace_extension(".actual.pbm");
+                            writePbm(actualPath, chip8, plane);
+                            golden.message = std::format("frame differs, wrote {}", actualPath.string());
+                        }
+                    }
+                });
+
+    int failures = 0;
+    for (const auto& golden : cases)
+    {
+        std::cout << std::format("{} {}{}\n", golden.passed ? "PASS" : "FAIL", golden.rom,
+                                 golden.message.empty() ? "" : ": " + golden.message);
+        failures += !golden.passed;
+    }
+
+    std::cout << std::format("{}/{} passed\n", cases.size() - failures, cases.size());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,156 @@
+// Memory heatmap: runs a ROM headless and counts reads, writes and executes per address.
+//
+//   chip8_heatmap <rom> [--frames n] [--quirks profile] [--keys frame:hexmask ...] [--out prefix]
+//
+// Writes <prefix>.csv and <prefix>.ppm (default prefix: the ROM file name) and prints where code and data live and
+// which addresses the ROM rewrites after executing them.
+
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "chip8.h"
+#include "heatmap.h"
+#include "rom.h"
+
+namespace
+{
+struct KeyEvent
+{
+    int frame;
+    uint16_t keys;
+};
+
+struct Options
+{
+    std::string romPath;
+    int frames = 600;
+    QuirkProfile quirks = QuirkProfile::Default;
+    std::vector<KeyEvent> script;
+    std::string outPrefix;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+
+    options.romPath = argv[1];
+    options.outPrefix = std::filesystem::path{argv[1]}.stem().string();
+    for (int i = 2; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc)
+        {
+            options.frames = std::atoi(argv[++i]);
+        }
+        else if (arg == "--quirks" && i + 1 < argc)
+        {
+            if (!ParseQuirkProfile(argv[++i], options.quirks))
+            {
+                return false;
+            }
+        }
+        else if (arg == "--out" && i + 1 < argc)
+        {
+            options.outPrefix = argv[++i];
+        }
+        else if (arg == "--keys" && i + 1 < argc)
+        {
+            // <frame>:<hex key mask>
+            const std::string event = argv[++i];
+            const auto colon = event.find(':');
+            if (colon == std::string::npos)
+            {
+                return false;
+            }
+            const auto keys = static_cast<uint16_t>(std::strtoul(event.substr(colon + 1).c_str(), nullptr, 16));
+            options.script.push_back({std::atoi(event.substr(0, colon).c_str()), keys});
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Contiguous runs of addresses matching pred, as "200-2ff 310"
+template <typename Pred>
+std::string ranges(Pred pred)
+{
+    std::string text;
+    for (int address = 0; address < 4096;)
+    {
+        if (!pred(address))
+        {
+            address++;
+            continue;
+        }
+        const auto start = address;
+        while (address < 4096 && pred(address))
+        {
+            address++;
+        }
+        const auto end = address - 1;
+        text += start == end ? std::format(" {:03x}", start) : std::format(" {:03x}-{:03x}", start, end);
+    }
+    return text.empty() ? " none" : text;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cout << "Usage: chip8_heatmap <rom> [--frames n] [--quirks profile] [--keys frame:hexmask ...] "
+                     "[--out prefix]\n";
+        return 1;
+    }
+
+    RomImage rom;
+    if (const auto error = ReadRomFile(options.romPath, rom, options.quirks); error != RomError::None)
+    {
+        std::cout << std::format("Failed to load rom {}: {}\n", options.romPath, RomErrorMessage(error));
+        return 1;
+    }
+
+    XoChip8 machine{1};
+    auto& chip8 = machine.chip8;
+    chip8.LoadRom(rom.Bytes(), options.quirks);
+
+    MemoryHeatmap heatmap;
+    size_t nextEvent = 0;
+    for (int frame = 0; frame < options.frames; frame++)
+    {
+        while (nextEvent < options.script.size() && options.script[nextEvent].frame <= frame)
+        {
+            chip8.input = options.script[nextEvent++].keys;
+        }
+        heatmap.Run(chip8, options.quirks, cyclesPerFrame);
+    }
+
+    std::cout << std::format("executed:{}\n", ranges([&](int a) { return heatmap.Executes(a) > 0; }));
+    std::cout << std::format("read:    {}\n", ranges([&](int a) { return heatmap.Reads(a) > 0; }));
+    std::cout << std::format("written: {}\n", ranges([&](int a) { return heatmap.Writes(a) > 0; }));
+    std::cout << std::format("self-modified:{}\n",
+                             ranges([&](int a) { return heatmap.Writes(a) > 0 && heatmap.Executes(a) > 0; }));
+
+    std::ofstream csv{options.outPrefix + ".csv"};
+    heatmap.WriteCsv(csv);
+    std::ofstream ppm{options.outPrefix + ".ppm", std::ios::binary};
+    heatmap.WritePpm(ppm);
+    if (!csv || !ppm)
+    {
+        std::cout << std::format("Failed to write {}.csv / {}.ppm\n", options.outPrefix, options.outPrefix);
+        return 1;
+    }
+    return 0;
+}
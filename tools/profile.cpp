@@ -0,0 +1,133 @@
+// Headless profiler: runs a ROM for a number of frames and reports where the emulated time goes.
+//
+//   chip8_profile <rom> [--frames n] [--quirks profile] [--sample n] [--keys frame:hexmask ...] [--collapsed file]
+//
+// Prints the hottest pcs, opcode classes and subroutines. --collapsed also writes the call stacks in the folded
+// format read by flamegraph.pl, speedscope and inferno.
+
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "chip8.h"
+#include "profiler.h"
+#include "rom.h"
+
+namespace
+{
+struct KeyEvent
+{
+    int frame;
+    uint16_t keys;
+};
+
+struct Options
+{
+    std::string romPath;
+    int frames = 600;
+    QuirkProfile quirks = QuirkProfile::Default;
+    uint32_t sampleInterval = 1;
+    std::vector<KeyEvent> script;
+    std::string collapsedPath;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+    if (argc < 2)
+    {
+        return false;
+    }
+
+    options.romPath = argv[1];
+    for (int i = 2; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc)
+        {
+            options.frames = std::atoi(argv[++i]);
+        }
+        else if (arg == "--quirks" && i + 1 < argc)
+        {
+            if (!ParseQuirkProfile(argv[++i], options.quirks))
+            {
+                return false;
+            }
+        }
+        else if (arg == "--sample" && i + 1 < argc)
+        {
+            options.sampleInterval = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--collapsed" && i + 1 < argc)
+        {
+            options.collapsedPath = argv[++i];
+        }
+        else if (arg == "--keys" && i + 1 < argc)
+        {
+            // <frame>:<hex key mask>
+            const std::string event = argv[++i];
+            const auto colon = event.find(':');
+            if (colon == std::string::npos)
+            {
+                return false;
+            }
+            const auto keys = static_cast<uint16_t>(std::strtoul(event.substr(colon + 1).c_str(), nullptr, 16));
+            options.script.push_back({std::atoi(event.substr(0, colon).c_str()), keys});
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cout << "Usage: chip8_profile <rom> [--frames n] [--quirks profile] [--sample n] "
+                     "[--keys frame:hexmask ...] [--collapsed file]\n";
+        return 1;
+    }
+
+    RomImage rom;
+    if (const auto error = ReadRomFile(options.romPath, rom, options.quirks); error != RomError::None)
+    {
+        std::cout << std::format("Failed to load rom {}: {}\n", options.romPath, RomErrorMessage(error));
+        return 1;
+    }
+
+    XoChip8 machine{1};
+    auto& chip8 = machine.chip8;
+    chip8.LoadRom(rom.Bytes(), options.quirks);
+
+    Profiler profiler{options.sampleInterval};
+    size_t nextEvent = 0;
+    for (int frame = 0; frame < options.frames; frame++)
+    {
+        while (nextEvent < options.script.size() && options.script[nextEvent].frame <= frame)
+        {
+            chip8.input = options.script[nextEvent++].keys;
+        }
+        profiler.Run(chip8, options.quirks, cyclesPerFrame);
+    }
+
+    profiler.WriteReport(std::cout);
+
+    if (!options.collapsedPath.empty())
+    {
+        std::ofstream out(options.collapsedPath);
+        if (!out)
+        {
+            std::cout << std::format("Failed to write {}\n", options.collapsedPath);
+            return 1;
+        }
+        profiler.WriteCollapsed(out);
+    }
+    return 0;
+}
@@ -0,0 +1,353 @@
+// Quirk profile detection.
+//
+// Runs each ROM headless under every quirk profile and several input scripts at once, scores how each run went and
+// records the best profile in the ROM database. A run is penalized for faults (unknown opcodes, executing outside
+// the program, stack under/overflow), for getting stuck on a blank screen, for frames that look like garbage and for
+// frames that differ from what most profiles show at the same point of the same script: quirks a ROM does not
+// depend on leave its screens alone, so the odd one out is the likely wrong one. Ties go to the lower profile, so
+// Default wins unless another profile does strictly better.
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "chip8.h"
+#include "parallel.h"
+#include "rom.h"
+#include "romdb.h"
+
+namespace
+{
+// Input scripts, each maps a frame number to the pressed key mask
+enum class Script
+{
+    None,
+    EveryKey,
+    Random,
+};
+
+constexpr int scriptCount = 3;
+
+uint16_t scriptKeys(Script script, int frame)
+{
+    switch (script)
+    {
+    case Script::EveryKey:
+    {
+        // Each key held for 10 frames then released for 10
+        return (frame / 10) % 2 ? 0 : 1 << ((frame / 20) % inputKeyCount);
+    }
+    case Script::Random:
+    {
+        // One key every 15 frames, fixed sequence
+        uint32_t state = 0x9e3779b9u ^ (frame / 15);
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return 1 << (state % inputKeyCount);
+    }
+    default:
+        return 0;
+    }
+}
+
+struct Outcome
+{
+    const char* fault = nullptr;
+    // The last instruction did not advance pc: a jump to itself, FX0A with no key or an opcode the profile does
+    // nothing for
+    bool halted = false;
+    bool blank = true;
+    int garbageFrames = 0;
+    // Hash of the screen at the end of each frame, the last one repeats after a fault
+    std::vector<uint64_t> screens;
+};
+
+uint64_t displayHash(const Chip8& chip8)
+{
+    uint64_t h = chip8.hires;
+    for (const auto& bitboard : chip8.display)
+    {
+        for (const auto row : bitboard)
+        {
+            h = (h ^ row) * 0x100000001b3ull;
+            h ^= h >> 29;
+        }
+    }
+    return h;
+}
+
+template <QuirkProfile profile>
+Outcome run(XoChip8 machine, Script script, int frames)
+{
+    auto& chip8 = machine.chip8;
+    Outcome outcome;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        chip8.input = scriptKeys(script, frame);
+
+        for (int cycle = 0; cycle < cyclesPerFrame; cycle++)
+        {
+            outcome.fault = PendingFault(chip8, profile);
+            if (outcome.fault)
+            {
+                break;
+            }
+            // Keeps running: FX0A stops making progress until the script presses a key
+            const auto pc = chip8.pc;
+            chip8.ExecuteNext<profile>();
+            outcome.halted = chip8.pc == pc;
+        }
+
+        // Also done for the frame a fault stopped the run in
+        int lit = 0;
+        for (const auto& bitboard : chip8.display)
+        {
+            for (const auto row : bitboard)
+            {
+                lit += std::popcount(row);
+            }
+        }
+        outcome.blank = outcome.blank && lit == 0;
+
+        // Real games rarely light more than half the screen, misread sprites and wrong I do
+        if (lit > chip8.DisplayWidth() * chip8.DisplayHeight() / 2)
+        {
+            outcome.garbageFrames++;
+        }
+        outcome.screens.push_back(displayHash(chip8));
+
+        if (outcome.fault)
+        {
+            outcome.screens.resize(frames, outcome.screens.back());
+            break;
+        }
+    }
+    return outcome;
+}
+
+Outcome run(QuirkProfile profile, const XoChip8& chip8, size_t romSize, Script script, int frames)
+{
+    // Only xochip has room for a ROM past 4 KiB, the others never get to run it
+    if (romSize > static_cast<size_t>(MaxRomSize(profile)))
+    {
+        Outcome outcome;
+        outcome.fault = RomErrorMessage(RomError::TooLarge);
+        outcome.screens.resize(frames, displayHash(chip8.chip8));
+        return outcome;
+    }
+
+    switch (profile)
+    {
+    case QuirkProfile::Cosmac:
+        return run<QuirkProfile::Cosmac>(chip8, script, frames);
+    case QuirkProfile::SuperChip:
+        return run<QuirkProfile::SuperChip>(chip8, script, frames);
+    case QuirkProfile::XoChip:
+        return run<QuirkProfile::XoChip>(chip8, script, frames);
+    default:
+        return run<QuirkProfile::Default>(chip8, script, frames);
+    }
+}
+
+// Lower is better. oddFrames are the frames whose screen differs from the majority, see oddFrames below.
+int penalty(const Outcome& outcome, int frames, int oddFrames)
+{
+    int score = 0;
+    if (outcome.fault)
+    {
+        score += 1000;
+    }
+    if (outcome.halted && outcome.blank)
+    {
+        score += 500;
+    }
+    return score + 100 * outcome.garbageFrames / frames + 100 * oddFrames / frames;
+}
+
+struct Rom
+{
+    std::string path;
+    std::string name;
+    // Loaded for xochip, the profile with the most memory
+    XoChip8 initial{1};
+    size_t size = 0;
+    Sha1Digest sha1{};
+    Outcome outcomes[quirkProfileCount][scriptCount];
+};
+
+// Runs that faulted or got stuck on a blank screen are already penalized, their screens carry no opinion
+bool votes(const Outcome& outcome) { return !outcome.fault && !(outcome.halted && outcome.blank); }
+
+// Frames at which profile shows another screen than most voting profiles do under the same script, a tied vote goes
+// to the screen of the lowest profile in it
+int oddFrames(const Rom& rom, int profile, int script, int frames)
+{
+    int odd = 0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        int bestVotes = 0;
+        uint64_t majority = rom.outcomes[profile][script].screens[frame];
+        for (const auto& outcomes : rom.outcomes)
+        {
+            const auto screen = outcomes[script].screens[frame];
+            int count = 0;
+            for (const auto& other : rom.outcomes)
+            {
+                count += votes(other[script]) && other[script].screens[frame] == screen;
+            }
+            if (count > bestVotes)
+            {
+                bestVotes = count;
+                majority = screen;
+            }
+        }
+        odd += rom.outcomes[profile][script].screens[frame] != majority;
+    }
+    return odd;
+}
+
+bool loadRom(const std::string& path, Rom& rom)
+{
+    RomImage image;
+    if (const auto error = ReadRomFile(path, image, QuirkProfile::XoChip); error != RomError::None)
+    {
+        std::cout << std::format("Failed to load rom {}: {}\n", path, RomErrorMessage(error));
+        return false;
+    }
+
+    rom.path = path;
+    rom.name = path.substr(path.find_last_of("/\\") + 1);
+    rom.sha1 = image.sha1;
+    rom.size = image.bytes.size();
+    rom.initial.chip8.LoadRom(image.Bytes(), QuirkProfile::XoChip);
+    return true;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    std::string dbPath = std::string{CHIP8_SOURCE_DIR} + "/rom/romdb.txt";
+    int frames = 600;
+    unsigned threads = 0;
+    bool dryRun = false;
+    std::vector<Rom> roms;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--db" && i + 1 < argc)
+        {
+            dbPath = argv[++i];
+        }
+        else if (arg == "--frames" && i + 1 < argc)
+        {
+            frames = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        }
+        else if (arg == "--dry-run")
+        {
+            dryRun = true;
+        }
+        else if (!loadRom(arg, roms.emplace_back()))
+        {
+            return 1;
+        }
+    }
+
+    if (roms.empty())
+    {
+        std::cout << "Usage: chip8_quirks <rom>... [--db file] [--frames n] [--threads n] [--dry-run]\n";
+        return 1;
+    }
+
+    // Every (rom, profile, script) run is independent
+    constexpr int runsPerRom = quirkProfileCount * scriptCount;
+    ParallelFor(roms.size() * runsPerRom, threads,
+                [&](size_t index, unsigned)
+                {
+                    auto& rom = roms[index / runsPerRom];
+                    const auto profile = static_cast<int>(index % runsPerRom) / scriptCount;
+                    const auto script = static_cast<int>(index % scriptCount);
+                    rom.outcomes[profile][script] = run(static_cast<QuirkProfile>(profile), rom.initial, rom.size,
+                                                        static_cast<Script>(script), frames);
+                });
+
+    std::vector<RomDbEntry> entries;
+    if (std::filesystem::exists(dbPath) && !ReadRomDb(dbPath, entries))
+    {
+        return 1;
+    }
+
+    for (const auto& rom : roms)
+    {
+        int best = 0;
+        int bestScore = 0;
+        std::cout << std::format("{}\n", rom.name);
+        for (int profile = 0; profile < quirkProfileCount; profile++)
+        {
+            int score = 0;
+            std::string notes;
+            for (int script = 0; script < scriptCount; script++)
+            {
+                const auto& outcome = rom.outcomes[profile][script];
+                const auto odd = oddFrames(rom, profile, script, frames);
+                score += penalty(outcome, frames, odd);
+                if (outcome.fault)
+                {
+                    notes += std::format(" {};", outcome.fault);
+                }
+                else if (outcome.halted && outcome.blank)
+                {
+                    notes += " halted blank;";
+                }
+                else if (outcome.garbageFrames)
+                {
+                    notes += std::format(" {} garbage frames;", outcome.garbageFrames);
+                }
+                else if (odd)
+                {
+                    notes += std::format(" {} frames unlike the others;", odd);
+                }
+            }
+
+            std::cout << std::format("  {:8} {:5}{}\n", QuirkProfileName(static_cast<QuirkProfile>(profile)), score,
+                                     notes);
+            if (profile == 0 || score < bestScore)
+            {
+                best = profile;
+                bestScore = score;
+            }
+        }
+
+        const auto quirks = static_cast<QuirkProfile>(best);
+        std::cout << std::format("  -> {} {}\n", QuirkProfileName(quirks), Sha1Hex(rom.sha1));
+
+        // Keep the speed, keymap and rewards of a known ROM
+        auto known = std::find_if(entries.begin(), entries.end(), [&](const auto& e) { return e.sha1 == rom.sha1; });
+        if (known == entries.end())
+        {
+            known = entries.insert(entries.end(), RomDbEntry{.sha1 = rom.sha1, .name = rom.name});
+        }
+        known->quirks = quirks;
+    }
+
+    if (dryRun)
+    {
+        return 0;
+    }
+    if (!WriteRomDb(dbPath, entries))
+    {
+        std::cout << std::format("Failed to write rom database {}\n", dbPath);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,351 @@
+// Static recompiler: translates a ROM into a C++ file that runs its basic blocks natively.
+//
+//   chip8_recompile <rom> <out.cpp> [--quirks profile] [--name identifier]
+//
+// The output registers a RecompiledProgram (src/recompiled.h) for the ROM's SHA-1 and the chosen profile. Link it
+// into a binary as an object and FindRecompiled returns it; the build does this for the ROMs in rom/.
+
+#include <cctype>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "analysis.h"
+#include "disasm.h"
+#include "rom.h"
+
+namespace
+{
+bool writesMemory(OpcodeClass opcodeClass)
+{
+    return opcodeClass == OpcodeClass::Bcd || opcodeClass == OpcodeClass::Store;
+}
+
+// Opcodes the profile does not know, the SUPER-CHIP ones included, keep the base interpreter's odd behaviour, which is
+// left to the interpreter. The XO-CHIP extensions are rare enough to always leave to it.
+bool translatable(OpcodeClass opcodeClass)
+{
+    switch (opcodeClass)
+    {
+    case OpcodeClass::Unknown:
+    case OpcodeClass::ScrollUp:
+    case OpcodeClass::SaveRange:
+    case OpcodeClass::LoadRange:
+    case OpcodeClass::LoadILong:
+    case OpcodeClass::Planes:
+    case OpcodeClass::Audio:
+    case OpcodeClass::Pitch:
+        return false;
+    default:
+        return true;
+    }
+}
+
+bool branches(OpcodeClass opcodeClass)
+{
+    switch (opcodeClass)
+    {
+    case OpcodeClass::Ret:
+    case OpcodeClass::Jump:
+    case OpcodeClass::Call:
+    case OpcodeClass::JumpOffset:
+    case OpcodeClass::SkipEqImm:
+    case OpcodeClass::SkipNeImm:
+    case OpcodeClass::SkipEqReg:
+    case OpcodeClass::SkipNeReg:
+    case OpcodeClass::SkipKey:
+    case OpcodeClass::SkipNoKey:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Statements for one instruction, ExecuteNext's behaviour under profile with the operands folded in. Branches set pc,
+// everything else leaves it to the block. WaitKey returns from the block itself. skipped is the length of the
+// instruction after it, what a taken skip steps over.
+std::string translate(uint16_t address, uint16_t opcode, int skipped, QuirkProfile profile, int executed)
+{
+    const auto quirks = QuirksOf(profile);
+    const auto x = (opcode >> 8) & 0xf;
+    const auto y = (opcode >> 4) & 0xf;
+    const auto n = opcode & 0xf;
+    const auto nn = opcode & 0xff;
+    const auto nnn = opcode & 0xfff;
+    const auto skip = (address + 2 + skipped) & 0xffff;
+    const auto next = (address + 2) & 0xffff;
+    const auto clearVf = quirks.logicClearsVf ? "    c.regs[0xf] = 0;\n" : "";
+
+    switch (ClassifyOpcode(opcode, profile))
+    {
+    case OpcodeClass::Cls:
+        return "    c.Clear();\n";
+    case OpcodeClass::Ret:
+        return "    c.sp--;\n    c.pc = c.stack[c.sp % stackSize];\n";
+    case OpcodeClass::Jump:
+        return std::format("    c.pc = 0x{:03x};\n", nnn);
+    case OpcodeClass::Call:
+        return std::format("    c.stack[c.sp % stackSize] = 0x{:03x};\n    c.sp++;\n    c.pc = 0x{:03x};\n", next, nnn);
+    case OpcodeClass::SkipEqImm:
+        return std::format("    c.pc = c.regs[0x{:x}] == 0x{:02x} ? 0x{:03x} : 0x{:03x};\n", x, nn, skip, next);
+    case OpcodeClass::SkipNeImm:
+        return std::format("    c.pc = c.regs[0x{:x}] != 0x{:02x} ? 0x{:03x} : 0x{:03x};\n", x, nn, skip, next);
+    case OpcodeClass::SkipEqReg:
+        return std::format("    c.pc = c.regs[0x{:x}] == c.regs[0x{:x}] ? 0x{:03x} : 0x{:03x};\n", x, y, skip, next);
+    case OpcodeClass::SkipNeReg:
+        return std::format("    c.pc = c.regs[0x{:x}] != c.regs[0x{:x}] ? 0x{:03x} : 0x{:03x};\n", x, y, skip, next);
+    case OpcodeClass::LoadImm:
+        return std::format("    c.regs[0x{:x}] = 0x{:02x};\n", x, nn);
+    case OpcodeClass::AddImm:
+        return std::format("    c.regs[0x{:x}] += 0x{:02x};\n", x, nn);
+    case OpcodeClass::Move:
+        return std::format("    c.regs[0x{:x}] = c.regs[0x{:x}];\n", x, y);
+    case OpcodeClass::Or:
+        return std::format("    c.regs[0x{:x}] |= c.regs[0x{:x}];\n{}", x, y, clearVf);
+    case OpcodeClass::And:
+        return std::format("    c.regs[0x{:x}] &= c.regs[0x{:x}];\n{}", x, y, clearVf);
+    case OpcodeClass::Xor:
+        return std::format("    c.regs[0x{:x}] ^= c.regs[0x{:x}];\n{}", x, y, clearVf);
+    case OpcodeClass::Add:
+        return std::format("    {{\n        const unsigned sum = c.regs[0x{0:x}] + c.regs[0x{1:x}];\n"
+                           "        c.regs[0x{0:x}] = sum & 0xff;\n        c.regs[0xf] = sum > 0xff;\n    }}\n",
+                           x, y);
+    case OpcodeClass::Sub:
+        return std::format("    c.regs[0xf] = !(c.regs[0x{1:x}] > c.regs[0x{0:x}]);\n"
+                           "    c.regs[0x{0:x}] -= c.regs[0x{1:x}];\n",
+                           x, y);
+    case OpcodeClass::SubReverse:
+        return std::format("    c.regs[0x{0:x}] = c.regs[0x{1:x}] - c.regs[0x{0:x}];\n"
+                           "    c.regs[0xf] = c.regs[0x{1:x}] > c.regs[0x{0:x}];\n",
+                           x, y);
+    case OpcodeClass::ShiftRight:
+        if (quirks.shiftReadsVy)
+        {
+            return std::format("    c.regs[0x{:x}] = c.regs[0x{:x}] >> 1;\n"
+                               "    c.regs[0xf] = c.regs[0x{:x}] & 1;\n",
+                               x, y, y);
+        }
+        return std::format("    {{\n        const uint8_t value = c.regs[0x{0:x}];\n"
+                           "        c.regs[0x{0:x}] = value >> 1;\n        c.regs[0xf] = value & 1;\n    }}\n",
+                           x);
+    case OpcodeClass::ShiftLeft:
+        if (quirks.shiftReadsVy)
+        {
+            return std::format("    c.regs[0x{:x}] = c.regs[0x{:x}] << 1;\n"
+                               "    c.regs[0xf] = c.regs[0x{:x}] >> 7 & 1;\n",
+                               x, y, y);
+        }
+        return std::format("    {{\n        const uint8_t value = c.regs[0x{0:x}];\n"
+                           "        c.regs[0x{0:x}] = value << 1;\n        c.regs[0xf] = value >> 7 & 1;\n    }}\n",
+                           x);
+    case OpcodeClass::LoadI:
+        return std::format("    c.ri = 0x{:03x};\n", nnn);
+    case OpcodeClass::JumpOffset:
+        return std::format("    c.pc = 0x{:03x} + c.regs[0x{:x}];\n", nnn, quirks.jumpAddsVx ? x : 0);
+    case OpcodeClass::Random:
+        return std::format("    c.regs[0x{:x}] = RecompiledRandom(c) & 0x{:02x};\n", x, nn);
+    case OpcodeClass::Draw:
+        return std::format("    c.DrawSprite<profile>(c.regs[0x{:x}], c.regs[0x{:x}], {});\n", x, y, n);
+    case OpcodeClass::SkipKey:
+        return std::format("    c.pc = c.KeyDown(c.regs[0x{:x}]) ? 0x{:03x} : 0x{:03x};\n", x, skip, next);
+    case OpcodeClass::SkipNoKey:
+        return std::format("    c.pc = !c.KeyDown(c.regs[0x{:x}]) ? 0x{:03x} : 0x{:03x};\n", x, skip, next);
+    case OpcodeClass::GetDelay:
+        return std::format("    c.regs[0x{:x}] = c.rdelay;\n", x);
+    case OpcodeClass::WaitKey:
+        // pc stays on the instruction until a key is down
+        return std::format("    if (!RecompiledWaitKey(c, 0x{:x}))\n    {{\n        c.pc = 0x{:03x};\n"
+                           "        RecompiledTick(c);\n        return {};\n    }}\n",
+                           x, address, executed + 1);
+    case OpcodeClass::SetDelay:
+        return std::format("    c.rdelay = c.regs[0x{:x}];\n", x);
+    case OpcodeClass::SetSound:
+        return std::format("    c.rsound = c.regs[0x{:x}];\n", x);
+    case OpcodeClass::AddI:
+        return std::format("    c.ri += c.regs[0x{:x}];\n", x);
+    case OpcodeClass::Font:
+        return std::format("    c.ri = (spriteSize * c.regs[0x{:x}] + spriteStartAddress) & 0xff;\n", x);
+    case OpcodeClass::Bcd:
+        return std::format("    {{\n        const auto value = c.regs[0x{0:x}];\n"
+                           "        c.MemoryAt<profile>(c.ri) = value / 100;\n"
+                           "        c.MemoryAt<profile>(c.ri + 1) = value % 100 / 10;\n"
+                           "        c.MemoryAt<profile>(c.ri + 2) = value % 10;\n    }}\n",
+                           x);
+    case OpcodeClass::Store:
+        return std::format("    for (int i = 0; i <= 0x{:x}; ++i)\n    {{\n"
+                           "        c.MemoryAt<profile>(c.ri + i) = c.regs[i];\n    }}\n{}",
+                           x, quirks.loadStoreAdvancesI ? std::format("    c.ri += 0x{:x};\n", x + 1) : "");
+    case OpcodeClass::Load:
+        return std::format("    for (int i = 0; i <= 0x{:x}; ++i)\n    {{\n"
+                           "        c.regs[i] = c.MemoryAt<profile>(c.ri + i);\n    }}\n{}",
+                           x, quirks.loadStoreAdvancesI ? std::format("    c.ri += 0x{:x};\n", x + 1) : "");
+    case OpcodeClass::ScrollDown:
+        return std::format("    c.ScrollDown({});\n", n);
+    case OpcodeClass::ScrollRight:
+        return "    c.ScrollRight();\n";
+    case OpcodeClass::ScrollLeft:
+        return "    c.ScrollLeft();\n";
+    case OpcodeClass::LowRes:
+        return "    c.SetHires(false);\n";
+    case OpcodeClass::HighRes:
+        return "    c.SetHires(true);\n";
+    default:
+        return {};
+    }
+}
+
+std::string identifierFrom(const std::string& path)
+{
+    std::string name = std::filesystem::path{path}.stem().string();
+    for (auto& c : name)
+    {
+        if (!std::isalnum(static_cast<unsigned char>(c)))
+        {
+            c = '_';
+        }
+    }
+    return name;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        std::cout << "Usage: chip8_recompile <rom> <out.cpp> [--quirks profile] [--name identifier]\n";
+        return 1;
+    }
+
+    QuirkProfile profile = QuirkProfile::Default;
+    std::string name = identifierFrom(argv[1]);
+    for (int i = 3; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--quirks" && i + 1 < argc && ParseQuirkProfile(argv[i + 1], profile))
+        {
+            i++;
+        }
+        else if (arg == "--name" && i + 1 < argc)
+        {
+            name = argv[++i];
+        }
+        else
+        {
+            std::cout << std::format("Unknown argument: {}\n", arg);
+            return 1;
+        }
+    }
+
+    RomImage rom;
+    if (const auto error = ReadRomFile(argv[1], rom, profile); error != RomError::None)
+    {
+        std::cout << std::format("Failed to load rom {}: {}\n", argv[1], RomErrorMessage(error));
+        return 1;
+    }
+    // Only the low 4 KiB is analysed, high memory just lets an XO-CHIP image load whole
+    XoChip8 machine;
+    auto& chip8 = machine.chip8;
+    chip8.LoadRom(rom.Bytes(), profile);
+    const auto analysis = AnalyzeProgram(chip8, profile);
+    const auto romEnd = static_cast<int>(romStartAddress + rom.Bytes().size());
+
+    std::string out = std::format("// Generated by chip8_recompile from {} ({} profile), do not edit.\n\n"
+                                  "#include <cstring>\n\n#include \"recompiled.h\"\n\nnamespace\n{{\n"
+                                  "constexpr auto profile = QuirkProfile::{};\n\n",
+                                  std::filesystem::path{argv[1]}.filename().string(), QuirkProfileName(profile),
+                                  profile == QuirkProfile::Cosmac      ? "Cosmac"
+                                  : profile == QuirkProfile::SuperChip ? "SuperChip"
+                                  : profile == QuirkProfile::XoChip    ? "XoChip"
+                                                                       : "Default");
+
+    out += std::format("// Blocks only run while their bytes still match the ROM\nconstexpr uint8_t image[{}] = {{",
+                       rom.Bytes().size());
+    for (size_t i = 0; i < rom.Bytes().size(); i++)
+    {
+        out += std::format("{}0x{:02x},", i % 12 == 0 ? "\n    " : " ", rom.Bytes()[i]);
+    }
+    out += "\n};\n\nbool intact(const Chip8& c, int start, int end)\n{\n"
+           "    return std::memcmp(&c.memory[start], &image[start - romStartAddress], end - start) == 0;\n}\n";
+
+    // Start and instruction count of every translated block, for the dispatch switch
+    std::string cases;
+    int translated = 0;
+    for (const auto& [start, block] : analysis.blocks)
+    {
+        // The block stops before the first opcode without a translation, the interpreter runs the rest
+        int end = start;
+        while (end < block.end &&
+               translatable(ClassifyOpcode(U8_CONCAT(chip8.memory[end], chip8.memory[end + 1]), profile)))
+        {
+            end += 2;
+        }
+        if (end <= start || end > romEnd)
+        {
+            continue;
+        }
+
+        out += std::format("\n// 0x{:03x}-0x{:03x}\nint block_{:03x}(Chip8& c)\n{{\n", start, end - 1, start);
+        int executed = 0;
+        auto lastClass = OpcodeClass::Unknown;
+        for (int address = start; address < end; address += 2)
+        {
+            const auto opcode = U8_CONCAT(chip8.memory[address], chip8.memory[address + 1]);
+            lastClass = ClassifyOpcode(opcode, profile);
+            out += std::format("    // {:03x}: {}\n", address, Disassemble(opcode, profile));
+            // Only XO-CHIP skips step over a whole F000 NNNN
+            const auto following = U8_CONCAT(chip8.memory[address + 2], chip8.memory[address + 3]);
+            const auto skipped = InstructionLength(following, profile);
+            out += translate(static_cast<uint16_t>(address), opcode, skipped, profile, executed);
+            out += "    RecompiledTick(c);\n";
+            executed++;
+
+            // A store into the rest of this block hands it back to the interpreter
+            if (writesMemory(lastClass) && address + 2 < end)
+            {
+                out += std::format("    if (!intact(c, 0x{0:03x}, 0x{1:03x}))\n    {{\n        c.pc = 0x{0:03x};\n"
+                                   "        return {2};\n    }}\n",
+                                   address + 2, end, executed);
+            }
+        }
+        if (!branches(lastClass))
+        {
+            out += std::format("    c.pc = 0x{:03x};\n", end);
+        }
+        out += std::format("    return {};\n}}\n", executed);
+
+        cases += std::format("        case 0x{0:03x}:\n"
+                             "            if (count >= {1} && intact(c, 0x{0:03x}, 0x{2:03x}))\n"
+                             "            {{\n                executed = block_{0:03x}(c);\n            }}\n"
+                             "            break;\n",
+                             start, executed, end);
+        translated++;
+    }
+
+    out += "\nvoid run(Chip8& c, int count)\n{\n    while (count > 0)\n    {\n        int executed = 0;\n"
+           "        switch (c.pc)\n        {\n";
+    out += cases;
+    out += "        default:\n            break;\n        }\n"
+           "        if (executed == 0)\n        {\n            c.ExecuteNext<profile>();\n            executed = 1;\n"
+           "        }\n        count -= executed;\n    }\n}\n\n";
+
+    std::string digest;
+    for (const auto byte : rom.sha1)
+    {
+        digest += std::format("{}0x{:02x}", digest.empty() ? "" : ", ", byte);
+    }
+    out += std::format("const bool registered = RegisterRecompiled({{\"{}\", {{{}}}, profile, run}});\n"
+                       "}}  // namespace\n",
+                       name, digest);
+
+    std::ofstream file(argv[2]);
+    file << out;
+    if (!file)
+    {
+        std::cout << std::format("Failed to write {}\n", argv[2]);
+        return 1;
+    }
+    std::cout << std::format("{}: {} of {} blocks translated\n", argv[2], translated, analysis.blocks.size());
+    return 0;
+}
@@ -0,0 +1,97 @@
+// ROM database tool.
+//
+//   chip8_romdb build <romdb.txt> <romdb.idx>   compile the text database into the memory-mapped index
+//   chip8_romdb lookup <romdb.idx> <rom>...     print the index entry of each ROM and the lookup time
+
+#include <chrono>
+#include <cstdio>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "romdb.h"
+
+namespace
+{
+int build(const std::string& textPath, const std::string& indexPath)
+{
+    std::vector<RomDbEntry> entries;
+    if (!ReadRomDb(textPath, entries))
+    {
+        std::cout << std::format("Failed to read rom database {}\n", textPath);
+        return 1;
+    }
+    if (!WriteRomIndex(indexPath, entries))
+    {
+        std::cout << std::format("Failed to write rom index {}\n", indexPath);
+        return 1;
+    }
+    return 0;
+}
+
+int lookup(const std::string& indexPath, const std::vector<std::string>& roms)
+{
+    using Clock = std::chrono::steady_clock;
+
+    auto start = Clock::now();
+    RomIndex index;
+    if (!index.Open(indexPath))
+    {
+        std::cout << std::format("Failed to open rom index {}\n", indexPath);
+        return 1;
+    }
+    std::cout << std::format("{} entries, opened in {:.1f} us\n", index.Size(),
+                             std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+
+    for (const auto& path : roms)
+    {
+        std::vector<uint8_t> data(xoMaxRomSize + 1);
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr)
+        {
+            std::cout << std::format("Failed to open rom: {}\n", path);
+            return 1;
+        }
+        data.resize(std::fread(data.data(), 1, data.size(), file));
+        std::fclose(file);
+
+        RomDbEntry entry;
+        start = Clock::now();
+        const bool found = index.Find(data.data(), data.size(), entry);
+        const auto micros = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+        if (!found)
+        {
+            std::cout << std::format("{}: not found ({:.1f} us)\n", path, micros);
+            continue;
+        }
+
+        std::string keys;
+        for (const auto key : entry.keymap)
+        {
+            keys += std::format("{:x}", key);
+        }
+        std::cout << std::format("{}: {} {} hz, keys {}, {} rewards ({:.1f} us)\n", path,
+                                 QuirkProfileName(entry.quirks), entry.hz, keys, entry.rewards.size(), micros);
+    }
+    return 0;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const std::string command = argc > 1 ? argv[1] : "";
+    if (command == "build" && argc == 4)
+    {
+        return build(argv[2], argv[3]);
+    }
+    if (command == "lookup" && argc >= 4)
+    {
+        return lookup(argv[2], {argv + 3, argv + argc});
+    }
+
+    std::cout << "Usage: chip8_romdb build <romdb.txt> <romdb.idx>\n"
+                 "       chip8_romdb lookup <romdb.idx> <rom>...\n";
+    return 1;
+}
@@ -0,0 +1,62 @@
+// Trace decoder: prints a binary instruction trace written by TraceRing::Dump as text, one instruction per line.
+//
+//   chip8_trace <trace> [--last n] [--pc addr]
+//
+// --last keeps only the newest n instructions, --pc only the ones at an address (hex).
+
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include "trace.h"
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: chip8_trace <trace> [--last n] [--pc addr]\n";
+        return 1;
+    }
+
+    size_t last = 0;
+    std::optional<uint16_t> pc;
+    for (int i = 2; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--last" && i + 1 < argc)
+        {
+            last = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--pc" && i + 1 < argc)
+        {
+            pc = static_cast<uint16_t>(std::strtoul(argv[++i], nullptr, 16));
+        }
+        else
+        {
+            std::cout << std::format("Unknown argument: {}\n", arg);
+            return 1;
+        }
+    }
+
+    TraceFile trace;
+    if (!ReadTrace(argv[1], trace))
+    {
+        std::cout << std::format("Failed to read trace {}\n", argv[1]);
+        return 1;
+    }
+
+    const size_t first = last && last < trace.records.size() ? trace.records.size() - last : 0;
+    std::cout << std::format("; {} profile\n     cycle  pc   op    form\n", QuirkProfileName(trace.profile));
+    for (size_t index = first; index < trace.records.size(); index++)
+    {
+        const auto& record = trace.records[index];
+        if (pc && record.pc != *pc)
+        {
+            continue;
+        }
+        std::cout << FormatTraceRecord(record, trace.Cycle(index), trace.profile) << '\n';
+    }
+    return 0;
+}
@@ -0,0 +1,7 @@
+#include "v1_oracle.h"
+
+namespace v1
+{
+#include "../v1_2022/src/Chip8.cpp"
+#include "../v1_2022/src/Keyboard.cpp"
+}  // namespace v1
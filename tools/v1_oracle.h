@@ -0,0 +1,68 @@
+#pragma once
+
+// The 2022 interpreter, built inside namespace v1 so it links next to the current core.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <stack>
+
+#include "chip8.h"
+
+namespace v1
+{
+#include "../v1_2022/src/Chip8.h"
+
+// Access to v1::Chip8 private state, declared a friend in v1_2022/src/Chip8.h
+struct Chip8Oracle
+{
+    // v1 leaves memory and registers uninitialized, start both cores from the same power-on state
+    static void Reset(Chip8& chip8)
+    {
+        std::memset(chip8.memory, 0, sizeof(chip8.memory));
+        std::memcpy(&chip8.memory[FONT_SET_START_ADDRESS], fontSet, sizeof(fontSet));
+        std::memset(chip8.V, 0, sizeof(chip8.V));
+        chip8.pc = MEMORY_ROM_START_ADDRESS;
+        chip8.I = 0;
+        chip8.DT = 0;
+        chip8.ST = 0;
+        chip8.stack = {};
+        chip8.ClearGfx();
+
+        // The constructor seeds rand() from the clock
+        std::srand(1);
+    }
+
+    // Copy the v1 state into the fields of the current core that have a v1 equivalent
+    static void Export(const Chip8& chip8, ::Chip8& out)
+    {
+        std::memcpy(out.regs, chip8.V, sizeof(out.regs));
+        out.pc = chip8.pc;
+        out.ri = chip8.I;
+        out.rdelay = chip8.DT;
+        out.rsound = chip8.ST;
+
+        auto stack = chip8.stack;
+        out.sp = static_cast<uint8_t>(stack.size());
+        for (int i = out.sp - 1; i >= 0; i--)
+        {
+            out.stack[i % stackSize] = stack.top();
+            stack.pop();
+        }
+
+        std::memcpy(out.memory, chip8.memory, sizeof(chip8.memory));
+        for (int y = 0; y < chip8Height; y++)
+        {
+            out.display[0][y] = 0;
+            for (int x = 0; x < chip8Width; x++)
+            {
+                out.display[0][y] |= static_cast<uint64_t>(chip8.gfx[y * GFX_WIDTH + x] != 0) << (63 - x);
+            }
+        }
+    }
+
+    static uint8_t& Register(Chip8& chip8, int index) { return chip8.V[index]; }
+};
+}  // namespace v1
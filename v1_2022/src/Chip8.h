@@ -37,6 +37,8 @@ const uint8_t fontSet[FONT_SET_SIZE] = {
 };
 
 class Chip8 {
+    // Read access for the differential runner in tools/
+    friend struct Chip8Oracle;
 private:
     uint16_t pc;
     uint8_t memory[MEMORY_SIZE];